@@ -0,0 +1,254 @@
+// Checks that each CPU kernel of encode_display_rgba8 gives the same colors
+// as the fragment shader that draws the window, on an offscreen EGL context.
+
+#include <window_blit/display_transform.hpp>
+
+#include "display_kernel.hpp"
+#include "egl_context.hpp"
+#include "shader.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+namespace {
+
+using namespace window_blit;
+
+/// Returned when there is no context to run the shader with, which CTest reports as skipped.
+const int g_exit_skipped = 77;
+
+/// Large enough to be split into chunks by encode_display_rgba8.
+const int g_image_size = 256;
+
+/// The kernels are meant to match the shader to within one step of the 8-bit encoding.
+const int g_max_difference = 1;
+
+/// Makes pixels that span from zero and denormals to far beyond the range of
+/// the tone mapping, including ones where a single channel dominates.
+std::vector<float>
+make_test_image(int channel_count)
+{
+  const std::size_t value_count = std::size_t(g_image_size) * g_image_size * channel_count;
+
+  std::vector<float> pixels(value_count);
+
+  std::uint32_t state = 1;
+
+  for (std::size_t i = 0; i < value_count; i++) {
+
+    state = (state * 1664525u) + 1013904223u;
+
+    const float r = float(state >> 8) / float(1 << 24);
+
+    switch (i % 97) {
+      case 0:
+        pixels[i] = 0;
+        break;
+      case 1:
+        pixels[i] = 1e-8f;
+        break;
+      case 2:
+        pixels[i] = 1e6f;
+        break;
+      default:
+        pixels[i] = std::exp2((r * 24.0f) - 16.0f);
+        break;
+    }
+  }
+
+  return pixels;
+}
+
+/// Draws the test image with the display shader of the window.
+class ShaderRenderer final
+{
+public:
+  bool setup()
+  {
+    const GLuint vert_shader = compile_shader(GL_VERTEX_SHADER, get_display_vert_shader(), std::cerr);
+
+    const GLuint frag_shader = compile_shader(GL_FRAGMENT_SHADER, get_display_frag_shader(), std::cerr);
+
+    if (!vert_shader || !frag_shader)
+      return false;
+
+    m_program = link_shader_program(vert_shader, frag_shader, std::cerr);
+
+    glDeleteShader(vert_shader);
+    glDeleteShader(frag_shader);
+
+    if (!m_program)
+      return false;
+
+    glUseProgram(m_program);
+
+    // The same quad as the window, so that the texture is drawn with the top row first.
+    const float vertices[8]{ -1, 1, -1, -1, 1, 1, 1, -1 };
+
+    GLuint vertex_buffer = 0;
+    glGenBuffers(1, &vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    const GLint pos_location = glGetAttribLocation(m_program, "g_pos");
+    glEnableVertexAttribArray(pos_location);
+    glVertexAttribPointer(pos_location, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, (void*)0);
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    GLuint renderbuffer = 0;
+    glGenRenderbuffers(1, &renderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, g_image_size, g_image_size);
+
+    GLuint framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      std::cerr << "The framebuffer for the shader is incomplete" << std::endl;
+      return false;
+    }
+
+    glViewport(0, 0, g_image_size, g_image_size);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    return true;
+  }
+
+  /// @return The encoded pixels, with the top row first like the CPU kernels.
+  std::vector<std::uint8_t> render(const std::vector<float>& pixels,
+                                   int channel_count,
+                                   const DisplayTransform& transform)
+  {
+    const GLenum format = (channel_count == 4) ? GL_RGBA : GL_RGB;
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, g_image_size, g_image_size, 0, format, GL_FLOAT, pixels.data());
+
+    glUniform1f(glGetUniformLocation(m_program, "g_sample_weight"), transform.sample_weight);
+    glUniform1f(glGetUniformLocation(m_program, "g_tone_mapping"), transform.tone_mapping);
+    glUniform1f(glGetUniformLocation(m_program, "g_srgb"), transform.srgb);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    const std::size_t row_size = std::size_t(g_image_size) * 4;
+
+    std::vector<std::uint8_t> rows(row_size * g_image_size);
+
+    glReadPixels(0, 0, g_image_size, g_image_size, GL_RGBA, GL_UNSIGNED_BYTE, rows.data());
+
+    // glReadPixels returns the bottom row first.
+    std::vector<std::uint8_t> rgba(rows.size());
+
+    for (int y = 0; y < g_image_size; y++)
+      std::copy_n(&rows[row_size * (g_image_size - 1 - y)], row_size, &rgba[row_size * y]);
+
+    return rgba;
+  }
+
+private:
+  GLuint m_program = 0;
+};
+
+int
+get_max_difference(const std::vector<std::uint8_t>& a, const std::vector<std::uint8_t>& b)
+{
+  int max_difference = 0;
+
+  for (std::size_t i = 0; i < a.size(); i++)
+    max_difference = std::max(max_difference, std::abs(int(a[i]) - int(b[i])));
+
+  return max_difference;
+}
+
+} // namespace
+
+int
+main()
+{
+  const auto context = EglContext::create();
+
+  if (!context) {
+    std::cerr << "Skipped, since there is no offscreen context to run the shader with" << std::endl;
+    return g_exit_skipped;
+  }
+
+  ShaderRenderer shader_renderer;
+
+  if (!shader_renderer.setup())
+    return EXIT_FAILURE;
+
+  const DisplayKernel kernels[]{ DisplayKernel::scalar, DisplayKernel::sse2, DisplayKernel::avx2, DisplayKernel::neon };
+
+  const float amounts[]{ 0.0f, 0.5f, 1.0f };
+
+  const float sample_weights[]{ 1.0f, 0.25f, 3.0f };
+
+  const std::size_t pixel_count = std::size_t(g_image_size) * g_image_size;
+
+  bool failed = false;
+
+  for (int channel_count = 3; channel_count <= 4; channel_count++) {
+
+    const std::vector<float> pixels = make_test_image(channel_count);
+
+    for (float sample_weight : sample_weights) {
+      for (float tone_mapping : amounts) {
+        for (float srgb : amounts) {
+
+          DisplayTransform transform;
+          transform.sample_weight = sample_weight;
+          transform.tone_mapping = tone_mapping;
+          transform.srgb = srgb;
+
+          const std::vector<std::uint8_t> expected = shader_renderer.render(pixels, channel_count, transform);
+
+          std::vector<std::uint8_t> rgba(pixel_count * 4);
+
+          auto check = [&](const char* name) {
+            const int max_difference = get_max_difference(expected, rgba);
+
+            if (max_difference <= g_max_difference)
+              return;
+
+            std::cerr << name << " differs from the shader by up to " << max_difference << " with " << channel_count
+                      << " channels, a sample weight of " << sample_weight << ", tone mapping of " << tone_mapping
+                      << " and sRGB of " << srgb << std::endl;
+
+            failed = true;
+          };
+
+          for (DisplayKernel kernel : kernels) {
+            if (is_display_kernel_supported(kernel)) {
+              encode_display_rgba8(kernel, pixels.data(), rgba.data(), pixel_count, transform, channel_count);
+              check(get_display_kernel_name(kernel));
+            }
+          }
+
+          // Also covers splitting the image between the threads.
+          encode_display_rgba8(pixels.data(), rgba.data(), pixel_count, transform, channel_count);
+          check("encode_display_rgba8");
+        }
+      }
+    }
+  }
+
+  for (DisplayKernel kernel : kernels) {
+    std::cout << get_display_kernel_name(kernel) << ": "
+              << (is_display_kernel_supported(kernel) ? "checked" : "not supported here") << std::endl;
+  }
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
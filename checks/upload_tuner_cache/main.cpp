@@ -0,0 +1,151 @@
+// Checks that the cache of the upload tuner round-trips its entries, and that
+// corrupt or partly written cache files are recovered from.
+
+#include "upload_tuner.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <system_error>
+
+#include <cstdlib>
+
+namespace {
+
+using namespace window_blit;
+
+const char g_key[] = "1|Vendor|Renderer|4.6.0";
+
+const char g_other_key[] = "1|Other Vendor|Other Renderer|3.3.0";
+
+bool g_failed = false;
+
+void
+expect(bool condition, const char* what)
+{
+  if (condition)
+    return;
+
+  std::cerr << "Failed: " << what << std::endl;
+
+  g_failed = true;
+}
+
+bool
+operator==(const UploadPreferences& a, const UploadPreferences& b)
+{
+  return (a.float_format == b.float_format) && (a.byte_layout == b.byte_layout);
+}
+
+void
+write_file(const std::filesystem::path& path, const std::string& contents)
+{
+  std::ofstream file(path, std::ios::binary);
+
+  file << contents;
+}
+
+/// Checks that the stored preferences for both keys are read back as they were.
+void
+check_round_trip(const std::filesystem::path& path,
+                 const UploadPreferences& preferences,
+                 const UploadPreferences& other_preferences)
+{
+  UploadPreferences read;
+
+  expect(read_cached_preferences(path, g_key, read), "the entry is read back");
+  expect(read == preferences, "the entry is read back unchanged");
+
+  UploadPreferences other_read;
+
+  expect(read_cached_preferences(path, g_other_key, other_read), "the other entry is read back");
+  expect(other_read == other_preferences, "the other entry is read back unchanged");
+}
+
+} // namespace
+
+int
+main()
+{
+  std::error_code error;
+
+  const std::filesystem::path dir =
+    std::filesystem::temp_directory_path(error) / ("window_blit_cache_check_" + std::to_string(std::random_device()()));
+
+  if (error || !std::filesystem::create_directories(dir, error)) {
+    std::cerr << "Failed to create a directory for the cache" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::filesystem::path path = dir / "window_blit" / "upload_formats.txt";
+
+  UploadPreferences preferences;
+  preferences.float_format = UploadFormat::rgb9_e5;
+  preferences.byte_layout = ByteLayout::bgra;
+
+  UploadPreferences other_preferences;
+  other_preferences.float_format = UploadFormat::rgba16f;
+  other_preferences.byte_layout = ByteLayout::rgba;
+
+  const UploadPreferences defaults;
+
+  {
+    UploadPreferences read;
+
+    expect(!read_cached_preferences(path, g_key, read), "a missing cache has no entry");
+    expect(read == defaults, "a missing cache leaves the preferences unchanged");
+  }
+
+  // Also creates the directory of the cache.
+  store_cached_preferences(path, g_key, preferences);
+  store_cached_preferences(path, g_other_key, other_preferences);
+
+  check_round_trip(path, preferences, other_preferences);
+
+  // Replacing an entry keeps the other one.
+  preferences.float_format = UploadFormat::rgb16f;
+
+  store_cached_preferences(path, g_key, preferences);
+
+  check_round_trip(path, preferences, other_preferences);
+
+  {
+    // Cut off in the middle of a format name, as if the writer was interrupted.
+    write_file(path, std::string(g_other_key) + "\trgba16f\trgba\n" + g_key + "\trgb1");
+
+    UploadPreferences read;
+
+    expect(!read_cached_preferences(path, g_key, read), "a partly written entry is ignored");
+    expect(read == defaults, "a partly written entry leaves the preferences unchanged");
+
+    store_cached_preferences(path, g_key, preferences);
+
+    check_round_trip(path, preferences, other_preferences);
+  }
+
+  {
+    write_file(path,
+               std::string("\x7f\x45\x4c\x46\x01\x02", 6) + "\n\t\t\t\n" + g_key + "\n" + g_key + "\trgb32f\n" + g_key +
+                 "\trgb32f\trgb\textra\n" + g_key + "\tunknown\trgb\n");
+
+    UploadPreferences read;
+
+    expect(!read_cached_preferences(path, g_key, read), "a corrupt cache has no entry");
+
+    store_cached_preferences(path, g_key, preferences);
+    store_cached_preferences(path, g_other_key, other_preferences);
+
+    check_round_trip(path, preferences, other_preferences);
+  }
+
+  for (const auto& entry : std::filesystem::directory_iterator(path.parent_path(), error)) {
+    if (entry.path() != path)
+      expect(false, "no temporary files are left behind");
+  }
+
+  std::filesystem::remove_all(dir, error);
+
+  return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
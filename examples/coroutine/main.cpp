@@ -0,0 +1,62 @@
+#include <window_blit/render_task.hpp>
+#include <window_blit/window_blit.hpp>
+
+#include <glm/glm.hpp>
+
+#include <random>
+#include <vector>
+
+#include <cmath>
+
+namespace {
+
+/// Renders an antialiased ring by adding one jittered sample per pixel on
+/// each step, with the sample count kept by the coroutine instead of a member.
+class CoroutineExample final : public window_blit::CoroutineApp
+{
+public:
+  using window_blit::CoroutineApp::CoroutineApp;
+
+  window_blit::RenderTask render_async(int w, int h) override
+  {
+    m_accumulator.assign(w * h, glm::vec3(0, 0, 0));
+
+    std::minstd_rand rng(w * h);
+
+    std::uniform_real_distribution<float> jitter(0, 1);
+
+    const float aspect = float(w) / h;
+
+    for (int pass = 1; pass <= m_max_pass_count; pass++) {
+
+      for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+
+          const float u = ((x + jitter(rng)) / w - 0.5f) * aspect;
+          const float v = (y + jitter(rng)) / h - 0.5f;
+
+          const float r = std::sqrt((u * u) + (v * v));
+
+          const bool inside = (r > 0.25f) && (r < 0.3f);
+
+          m_accumulator[(y * w) + x] += inside ? glm::vec3(1.0f, 0.5f, 0.1f) : glm::vec3(0.05f);
+        }
+      }
+
+      co_yield window_blit::FrameProgress{ &m_accumulator[0].x, 3, w, h, 1.0f / pass };
+    }
+  }
+
+private:
+  std::vector<glm::vec3> m_accumulator;
+
+  int m_max_pass_count = 256;
+};
+
+} // namespace
+
+int
+main()
+{
+  return window_blit::run_glfw_window(window_blit::AppFactory<CoroutineExample>());
+}
@@ -1,7 +1,5 @@
 #include <window_blit/window_blit.hpp>
 
-#include <vector>
-
 namespace {
 
 class MinimalExample final : public window_blit::AppBase
@@ -9,24 +7,35 @@ class MinimalExample final : public window_blit::AppBase
 public:
   using window_blit::AppBase::AppBase;
 
-  void render(GLuint texture_id, int w, int h) override
+  void render(GLuint /* texture_id */, int w, int h) override
   {
-    std::vector<float> rgb(w * h * 3);
+    // The pixels are written straight into the memory that the texture is
+    // uploaded from, so no intermediate buffer is needed.
+    const auto framebuffer = map_framebuffer(w, h);
+
+    if (!framebuffer.rgb)
+      return;
 
-    for (int i = 0; i < (w * h); i++) {
+    for (int y = 0; y < h; y++) {
 
-      int x = i % w;
-      int y = i / w;
+      float* row = framebuffer.get_row(y);
 
-      float u = (x + 0.5f) / w;
-      float v = (y + 0.5f) / h;
+      for (int x = 0; x < w; x++) {
 
-      rgb[(i * 3) + 0] = u;
-      rgb[(i * 3) + 1] = v;
-      rgb[(i * 3) + 2] = 1;
+        float u = (x + 0.5f) / w;
+        float v = (y + 0.5f) / h;
+
+        row[(x * 3) + 0] = u;
+        row[(x * 3) + 1] = v;
+        row[(x * 3) + 2] = 1;
+      }
     }
 
-    load_rgb(&rgb[0], w, h, texture_id);
+    unmap_framebuffer();
+
+    // The image only depends on the size of the window, so it does not need to
+    // be rendered again until the window is resized.
+    set_converged();
   }
 };
 
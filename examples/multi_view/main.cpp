@@ -0,0 +1,234 @@
+#include <window_blit/window_blit.hpp>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <cmath>
+
+namespace {
+
+struct Ray final
+{
+  glm::vec3 org;
+
+  glm::vec3 dir;
+};
+
+struct Sphere final
+{
+  glm::vec3 center;
+
+  float radius;
+
+  glm::vec3 albedo;
+};
+
+struct Hit final
+{
+  float distance = std::numeric_limits<float>::infinity();
+
+  glm::vec3 normal{ 0, 0, 0 };
+
+  glm::vec3 albedo{ 0, 0, 0 };
+
+  operator bool() const noexcept { return distance < std::numeric_limits<float>::infinity(); }
+};
+
+/// The scene that all of the windows show. It is not changed once created, so
+/// the render threads of the windows can all read it at the same time.
+class Scene final
+{
+public:
+  Scene()
+  {
+    m_spheres.emplace_back(Sphere{ glm::vec3(0, -1001, -5), 1000, glm::vec3(0.8f, 0.8f, 0.8f) });
+    m_spheres.emplace_back(Sphere{ glm::vec3(-1.5f, 0, -5), 1, glm::vec3(0.9f, 0.3f, 0.2f) });
+    m_spheres.emplace_back(Sphere{ glm::vec3(1.5f, 0, -6), 1, glm::vec3(0.2f, 0.5f, 0.9f) });
+    m_spheres.emplace_back(Sphere{ glm::vec3(0, -0.5f, -3.5f), 0.5f, glm::vec3(0.9f, 0.8f, 0.2f) });
+  }
+
+  Hit intersect(const Ray& ray) const
+  {
+    Hit hit;
+
+    for (const auto& sphere : m_spheres) {
+
+      const glm::vec3 oc = ray.org - sphere.center;
+
+      const float b = glm::dot(oc, ray.dir);
+      const float c = glm::dot(oc, oc) - (sphere.radius * sphere.radius);
+
+      const float discriminant = (b * b) - c;
+
+      if (discriminant < 0)
+        continue;
+
+      const float distance = -b - std::sqrt(discriminant);
+
+      if ((distance > 1e-3f) && (distance < hit.distance)) {
+        hit.distance = distance;
+        hit.normal = glm::normalize((ray.org + (ray.dir * distance)) - sphere.center);
+        hit.albedo = sphere.albedo;
+      }
+    }
+
+    return hit;
+  }
+
+private:
+  std::vector<Sphere> m_spheres;
+};
+
+/// What a window shows of the scene.
+enum class Channel
+{
+  /// Diffuse shading with shadows, which takes the most work to converge.
+  color,
+  normal,
+  depth
+};
+
+/// Shows one channel of the shared scene. Each window has a camera of its
+/// own, and the windows get render time in proportion to their priority.
+template<Channel channel>
+class ViewApp final : public window_blit::AppBase
+{
+public:
+  ViewApp(GLFWwindow* window, std::shared_ptr<Scene> scene)
+    : AppBase(window)
+    , m_scene(std::move(scene))
+  {
+    set_threaded_render(true);
+
+    // There is one render worker for all of the windows, and most of its time
+    // goes to the shaded view, since the other channels converge on their own
+    // after a few samples.
+    set_render_priority((channel == Channel::color) ? 4.0f : 1.0f);
+  }
+
+  bool render_slice(int w, int h, int work) override
+  {
+    const float aspect = float(w) / h;
+
+    const float rcp_w = 1.0f / w;
+    const float rcp_h = 1.0f / h;
+
+    const glm::vec3 camera_position = get_camera_position();
+    const glm::mat3 camera_rotation = get_camera_rotation_transform();
+
+    for (int s = 0; (s < work) && (m_sample_count < m_max_sample_count); s++) {
+
+      // The same subpixel offset for every pixel of a sample, from a low
+      // discrepancy sequence, so that the samples cover the pixels evenly.
+      const float jitter_x = std::fmod(0.5f + (m_sample_count * 0.7548777f), 1.0f);
+      const float jitter_y = std::fmod(0.5f + (m_sample_count * 0.5698403f), 1.0f);
+
+#pragma omp parallel for
+
+      for (int i = 0; i < (w * h); i++) {
+
+        const float u = ((i % w) + jitter_x) * rcp_w;
+        const float v = ((i / w) + jitter_y) * rcp_h;
+
+        const glm::vec3 dir(((2.0f * u) - 1.0f) * 0.5f * aspect, (1.0f - (2.0f * v)) * 0.5f, -1.0f);
+
+        m_accumulator[i] += shade(Ray{ camera_position, camera_rotation * glm::normalize(dir) });
+      }
+
+      m_sample_count++;
+    }
+
+    return m_sample_count < m_max_sample_count;
+  }
+
+  void finish_frame(GLuint texture_id, int w, int h) override
+  {
+    if (!m_sample_count)
+      return;
+
+    set_sample_weight(1.0f / m_sample_count);
+
+    load_rgb(&m_accumulator[0], w, h, texture_id);
+  }
+
+  void on_resize(int w, int h) override
+  {
+    m_accumulator.resize(w * h);
+
+    reset();
+
+    AppBase::on_resize(w, h);
+  }
+
+  void on_camera_change() override { reset(); }
+
+private:
+  glm::vec3 shade(const Ray& ray) const
+  {
+    const Hit hit = m_scene->intersect(ray);
+
+    switch (channel) {
+      case Channel::color:
+        break;
+      case Channel::normal:
+        return hit ? ((hit.normal * 0.5f) + glm::vec3(0.5f, 0.5f, 0.5f)) : glm::vec3(0, 0, 0);
+      case Channel::depth:
+        return glm::vec3(1, 1, 1) * (hit ? (1.0f / (1.0f + (hit.distance * 0.25f))) : 0.0f);
+    }
+
+    if (!hit) {
+      const float t = 0.5f * (ray.dir.y + 1.0f);
+      return (glm::vec3(1, 1, 1) * (1.0f - t)) + (glm::vec3(0.5f, 0.7f, 1.0f) * t);
+    }
+
+    const glm::vec3 light_dir = glm::normalize(glm::vec3(1, 2, 1));
+
+    const glm::vec3 pos = ray.org + (ray.dir * hit.distance);
+
+    const bool lit = !m_scene->intersect(Ray{ pos, light_dir });
+
+    const float diffuse = lit ? std::max(glm::dot(hit.normal, light_dir), 0.0f) : 0.0f;
+
+    return hit.albedo * (0.1f + (0.9f * diffuse));
+  }
+
+  void reset()
+  {
+    std::fill(m_accumulator.begin(), m_accumulator.end(), glm::vec3(0, 0, 0));
+
+    m_sample_count = 0;
+  }
+
+private:
+  std::shared_ptr<Scene> m_scene;
+
+  window_blit::PooledBuffer<glm::vec3> m_accumulator{ get_buffer_pool() };
+
+  int m_sample_count = 0;
+
+  int m_max_sample_count = 256;
+};
+
+} // namespace
+
+int
+main()
+{
+  auto scene = std::make_shared<Scene>();
+
+  window_blit::SharedAppFactory<ViewApp<Channel::color>, Scene> color_factory(scene);
+
+  window_blit::SharedAppFactory<ViewApp<Channel::normal>, Scene> normal_factory(scene);
+
+  window_blit::SharedAppFactory<ViewApp<Channel::depth>, Scene> depth_factory(scene);
+
+  window_blit::RunOptions options;
+
+  options.title = "Multi View";
+
+  return window_blit::run_glfw_windows({ &color_factory, &normal_factory, &depth_factory }, options);
+}
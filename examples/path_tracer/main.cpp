@@ -9,10 +9,13 @@
 #include <algorithm>
 #include <limits>
 #include <random>
+#include <string>
 #include <vector>
 
 #include <iostream>
 
+#include <cstdlib>
+
 namespace {
 
 struct Ray final
@@ -105,17 +108,29 @@ class ExampleApp final : public window_blit::AppBase
 public:
   ExampleApp(GLFWwindow* window);
 
-  void render(GLuint texture_id, int w, int h) override;
+  bool render_slice(int w, int h, int work) override;
+
+  void finish_frame(GLuint texture_id, int w, int h) override;
 
   void on_resize(int w, int h) override;
 
   void on_camera_change() override;
 
+  void on_frame_seed(unsigned int seed) override;
+
 private:
   void reset();
 
+  /// Seeds the generators of a range of pixels from their index and @ref m_frame_seed.
+  void seed_rngs(int first, int last);
+
   template<typename Rng>
-  auto generate_ray(glm::vec2 uv_min, glm::vec2 uv_max, float aspect, Rng& rng) -> Ray;
+  auto generate_ray(glm::vec2 uv_min,
+                    glm::vec2 uv_max,
+                    float aspect,
+                    const glm::vec3& camera_position,
+                    const glm::mat3& camera_rotation,
+                    Rng& rng) -> Ray;
 
   auto intersect_scene(const Ray& ray) const -> Hit;
 
@@ -129,15 +144,20 @@ private:
 
   void create_scene();
 
-  std::vector<glm::vec3> m_accumulator;
+  /// Padded to four channels, which is the layout that the texture is stored in.
+  window_blit::PooledBuffer<glm::vec4> m_accumulator{ get_buffer_pool() };
 
-  std::vector<std::minstd_rand> m_rngs;
+  /// Only grows, so that the generators of existing pixels are only seeded
+  /// again when a larger block is taken from the pool.
+  window_blit::PooledBuffer<std::minstd_rand> m_rngs{ get_buffer_pool() };
 
-  int m_resolution_divisor = 8;
+  /// The index of the animation frame being rendered, so that each frame gets the same samples on any app.
+  int m_frame_seed = 0;
 
   int m_sample_count = 0;
 
-  int m_samples_per_frame = 512;
+  /// Once this many samples are accumulated, the image is considered converged.
+  int m_max_sample_count = 4096;
 
   std::vector<Sphere> m_spheres;
 
@@ -147,37 +167,26 @@ private:
 ExampleApp::ExampleApp(GLFWwindow* window)
   : AppBase(window)
 {
-  int w = 0;
-  int h = 0;
-  glfwGetWindowSize(window, &w, &h);
-
-  w /= m_resolution_divisor;
-  h /= m_resolution_divisor;
+  // The accumulator is sized by on_resize, before the first frame.
+  create_scene();
 
-  m_accumulator.resize(w * h);
+  // Lets the next frame be traced while this one is being uploaded.
+  set_async_upload(true);
 
-  m_rngs.resize(w * h);
+  // The noise of the samples hides the precision that the smaller formats lose, so the fastest one will do.
+  set_upload_format(window_blit::UploadFormat::automatic);
 
-  reset();
+  // Keeps the window responsive while the samples of a frame are traced.
+  set_threaded_render(true);
 
-  create_scene();
+  // Lowers the resolution until a sample per pixel fits into a frame, so that moving the camera stays smooth.
+  set_dynamic_resolution(true);
 }
 
 void
 ExampleApp::reset()
 {
-  std::seed_seq seed{ int(m_rngs.size()), 1234 };
-
-  std::mt19937 seed_rng(seed);
-
-  for (int i = 0; i < int(m_rngs.size()); i++) {
-
-    m_accumulator[i] = glm::vec3(0, 0, 0);
-
-    std::seed_seq pixel_seed{ i, int(seed_rng()) };
-
-    m_rngs[i] = std::minstd_rand(pixel_seed);
-  }
+  std::fill(m_accumulator.begin(), m_accumulator.end(), glm::vec4(0, 0, 0, 0));
 
   m_sample_count = 0;
 }
@@ -188,6 +197,25 @@ ExampleApp::on_camera_change()
   reset();
 }
 
+void
+ExampleApp::on_frame_seed(unsigned int seed)
+{
+  m_frame_seed = int(seed);
+
+  seed_rngs(0, int(m_rngs.size()));
+}
+
+void
+ExampleApp::seed_rngs(int first, int last)
+{
+  for (int i = first; i < last; i++) {
+
+    std::seed_seq pixel_seed{ i, 1234, m_frame_seed };
+
+    m_rngs[i] = std::minstd_rand(pixel_seed);
+  }
+}
+
 void
 ExampleApp::create_scene()
 {
@@ -233,52 +261,80 @@ ExampleApp::intersect_scene(const Ray& ray) const
   return to_hit(ray, m_spheres[index], closest_sphere_hit, index);
 }
 
-void
-ExampleApp::render(GLuint texture_id, int window_w, int window_h)
+bool
+ExampleApp::render_slice(int w, int h, int work)
 {
-  reset();
-
-  const int w = window_w / m_resolution_divisor;
-  const int h = window_h / m_resolution_divisor;
-
   const float aspect = float(w) / h;
 
   const float rcp_w = 1.0f / w;
   const float rcp_h = 1.0f / h;
 
-  for (int s = 0; s < m_samples_per_frame; s++) {
-#pragma omp parallel for
+  // Read once, since the camera is guarded by a lock and every ray of the slice has to see the same camera.
+  const glm::vec3 camera_position = get_camera_position();
+  const glm::mat3 camera_rotation = get_camera_rotation_transform();
+
+  auto trace_pixel = [&](int i) {
+    const int x = i % w;
+    const int y = i / w;
+
+    const glm::vec2 uv_min((x + 0.0f) * rcp_w, (y + 0.0f) * rcp_h);
+    const glm::vec2 uv_max((x + 1.0f) * rcp_w, (y + 1.0f) * rcp_h);
+
+    const auto ray = generate_ray(uv_min, uv_max, aspect, camera_position, camera_rotation, m_rngs[i]);
 
-    for (int i = 0; i < (w * h); i++) {
+    m_accumulator[i] += glm::vec4(trace(ray, m_rngs[i]), 0.0f);
+  };
 
-      const int x = i % w;
-      const int y = i / w;
+  // Only limited when several frames are rendered at once, otherwise OpenMP picks the number of threads.
+  const int thread_count = get_pixel_thread_count();
 
-      const glm::vec2 uv_min((x + 0.0f) * rcp_w, (y + 0.0f) * rcp_h);
-      const glm::vec2 uv_max((x + 1.0f) * rcp_w, (y + 1.0f) * rcp_h);
+  // Samples keep accumulating across frames, until the camera moves or the window is resized.
+  for (int s = 0; (s < work) && (m_sample_count < m_max_sample_count); s++) {
 
-      const auto ray = generate_ray(uv_min, uv_max, aspect, m_rngs[i]);
+    if (thread_count > 0) {
+#pragma omp parallel for num_threads(thread_count)
 
-      m_accumulator[i] += trace(ray, m_rngs[i]);
+      for (int i = 0; i < (w * h); i++)
+        trace_pixel(i);
+
+    } else {
+#pragma omp parallel for
+
+      for (int i = 0; i < (w * h); i++)
+        trace_pixel(i);
     }
 
     m_sample_count++;
   }
 
+  return m_sample_count < m_max_sample_count;
+}
+
+void
+ExampleApp::finish_frame(GLuint texture_id, int w, int h)
+{
+  if (!m_sample_count)
+    return;
+
   set_sample_weight(1.0f / m_sample_count);
 
-  load_rgb(&m_accumulator[0], w, h, texture_id);
+  load_rgba(&m_accumulator[0], w, h, texture_id);
 }
 
 void
 ExampleApp::on_resize(int w, int h)
 {
-  w = w / m_resolution_divisor;
-  h = h / m_resolution_divisor;
-
   m_accumulator.resize(w * h);
 
-  m_rngs.resize(w * h);
+  if (m_rngs.size() < std::size_t(w * h)) {
+
+    // The generators are only kept along with the block.
+    const int seeded_rng_count = (m_rngs.capacity() >= std::size_t(w * h)) ? int(m_rngs.size()) : 0;
+
+    m_rngs.resize(w * h);
+
+    seed_rngs(seeded_rng_count, w * h);
+  }
 
   reset();
 
@@ -287,7 +343,12 @@ ExampleApp::on_resize(int w, int h)
 
 template<typename Rng>
 Ray
-ExampleApp::generate_ray(glm::vec2 uv_min, glm::vec2 uv_max, float aspect, Rng& rng)
+ExampleApp::generate_ray(glm::vec2 uv_min,
+                         glm::vec2 uv_max,
+                         float aspect,
+                         const glm::vec3& camera_position,
+                         const glm::mat3& camera_rotation,
+                         Rng& rng)
 {
   std::uniform_real_distribution<float> x_dist(uv_min.x, uv_max.x);
   std::uniform_real_distribution<float> y_dist(uv_min.y, uv_max.y);
@@ -298,11 +359,9 @@ ExampleApp::generate_ray(glm::vec2 uv_min, glm::vec2 uv_max, float aspect, Rng&
   const float u = x_dist(rng);
   const float v = y_dist(rng);
 
-  const glm::vec3 org = get_camera_position();
-
   const glm::vec3 dir(((2.0f * u) - 1.0f) * fov_x, (1.0f - (2.0f * v)) * fov_y, -1.0f);
 
-  return Ray{ org, get_camera_rotation_transform() * glm::normalize(dir) };
+  return Ray{ camera_position, camera_rotation * glm::normalize(dir) };
 }
 
 template<typename Rng>
@@ -365,8 +424,68 @@ int
 #ifdef _WIN32
 wWinMain(HINSTANCE, HINSTANCE, PWSTR, int)
 #else
-main()
+main(int argc, char** argv)
 #endif
 {
+#ifndef _WIN32
+  // Renders until converged and writes the image, for machines without a display. With an input recording, the
+  // recorded session is replayed instead.
+  if ((argc > 1) && (std::string(argv[1]) == "--headless")) {
+
+    window_blit::HeadlessOptions options;
+    options.output_path = (argc > 2) ? argv[2] : "path_tracer.png";
+    options.replay_path = (argc > 3) ? argv[3] : nullptr;
+    options.print_statistics = true;
+
+    return window_blit::run_headless(window_blit::AppFactory<ExampleApp>(), options);
+  }
+
+  // The same, but drawn through the display shader of the window on an offscreen context.
+  if ((argc > 1) && (std::string(argv[1]) == "--offscreen")) {
+
+    window_blit::HeadlessOptions options;
+    options.output_path = (argc > 2) ? argv[2] : "path_tracer.png";
+    options.replay_path = (argc > 3) ? argv[3] : nullptr;
+    options.print_statistics = true;
+
+    return window_blit::run_offscreen(window_blit::AppFactory<ExampleApp>(), options);
+  }
+
+  // Renders a camera path to numbered images, several frames at a time.
+  if ((argc > 2) && (std::string(argv[1]) == "--animation")) {
+
+    std::vector<window_blit::CameraKeyframe> keyframes;
+
+    if (!window_blit::load_camera_keyframes(argv[2], keyframes))
+      return EXIT_FAILURE;
+
+    window_blit::AnimationOptions options;
+    options.output_pattern = (argc > 3) ? argv[3] : "path_tracer_%04d.png";
+    options.frame_thread_count = (argc > 4) ? std::atoi(argv[4]) : 1;
+    options.pixel_thread_count = (argc > 5) ? std::atoi(argv[5]) : 0;
+    options.print_statistics = true;
+
+    return window_blit::run_animation(window_blit::AppFactory<ExampleApp>(), keyframes, options);
+  }
+
+  // Records the input of the window, or replays a recording as fast as the frames allow, to compare frame times.
+  if ((argc > 2) && (std::string(argv[1]) == "--record")) {
+
+    window_blit::RunOptions options;
+    options.record_path = argv[2];
+
+    return window_blit::run_glfw_window(window_blit::AppFactory<ExampleApp>(), options);
+  }
+
+  if ((argc > 2) && (std::string(argv[1]) == "--replay")) {
+
+    window_blit::RunOptions options;
+    options.replay_path = argv[2];
+    options.present_mode = window_blit::PresentMode::immediate;
+
+    return window_blit::run_glfw_window(window_blit::AppFactory<ExampleApp>(), options);
+  }
+#endif
+
   return window_blit::run_glfw_window(window_blit::AppFactory<ExampleApp>());
 }
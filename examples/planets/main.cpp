@@ -32,7 +32,7 @@ public:
   {
     ImGui::InputInt("Sample Count", &m_sample_count, 1, 256);
 
-    ImGui::InputInt("Resolution Divisor", &m_resolution_divisor, 1, 8);
+    ImGui::Text("Resolution Scale = %.2f", get_resolution_scale());
   }
 
 private:
@@ -41,73 +41,70 @@ private:
 
   Scene m_scene;
 
-  std::vector<glm::vec3> m_color;
-
-  int m_resolution_divisor = 1;
+  window_blit::PooledBuffer<glm::vec3> m_color{ get_buffer_pool() };
 
   int m_sample_count = 4;
+
+  int m_band_height = 32;
 };
 
 ExampleApp::ExampleApp(GLFWwindow* window)
   : AppBase(window)
 {
-  int w = 0;
-  int h = 0;
-  glfwGetWindowSize(window, &w, &h);
-
-  on_resize(w, h);
+  // The size of the color buffer is set by on_resize, before the first frame.
+  set_dynamic_resolution(true);
 }
 
 void
-ExampleApp::render(GLuint texture_id, int window_w, int window_h)
+ExampleApp::render(GLuint texture_id, int w, int h)
 {
-  const int w = window_w / m_resolution_divisor;
-  const int h = window_h / m_resolution_divisor;
-
   const float aspect = float(w) / h;
 
   const float rcp_w = 1.0f / w;
   const float rcp_h = 1.0f / h;
 
+  set_sample_weight(1.0f / m_sample_count);
+
+  // Each band is uploaded as soon as it is done, while the next one is traced.
+  for (int band_y = 0; band_y < h; band_y += m_band_height) {
+
+    const int band_end = std::min(band_y + m_band_height, h);
+
 #pragma omp parallel for
 
-  for (int i = 0; i < (w * h); i++) {
+    for (int i = band_y * w; i < (band_end * w); i++) {
+
+      const int x = i % w;
+      const int y = i / w;
 
-    const int x = i % w;
-    const int y = i / w;
+      std::seed_seq seed{ x, y, w * h };
 
-    std::seed_seq seed{ x, y, w * h };
+      std::minstd_rand rng(seed);
 
-    std::minstd_rand rng(seed);
+      const glm::vec2 uv_min((x + 0.0f) * rcp_w, (y + 0.0f) * rcp_h);
+      const glm::vec2 uv_max((x + 1.0f) * rcp_w, (y + 1.0f) * rcp_h);
 
-    const glm::vec2 uv_min((x + 0.0f) * rcp_w, (y + 0.0f) * rcp_h);
-    const glm::vec2 uv_max((x + 1.0f) * rcp_w, (y + 1.0f) * rcp_h);
+      glm::vec3 color{ 0, 0, 0 };
 
-    glm::vec3 color{ 0, 0, 0 };
+      for (int j = 0; j < m_sample_count; j++) {
 
-    for (int j = 0; j < m_sample_count; j++) {
+        const auto ray = generate_ray(uv_min, uv_max, aspect, rng);
 
-      const auto ray = generate_ray(uv_min, uv_max, aspect, rng);
+        color += m_scene.trace(ray, rng);
+      }
 
-      color += m_scene.trace(ray, rng);
+      m_color[i] = color;
     }
 
-    m_color[i] = color;
+    load_rgb_rows(&m_color[0], w, h, band_y, band_end - band_y, texture_id);
   }
 
-  set_sample_weight(1.0f / m_sample_count);
-
-  load_rgb(&m_color[0], w, h, texture_id);
-
   m_scene.advance();
 }
 
 void
 ExampleApp::on_resize(int w, int h)
 {
-  w = w / m_resolution_divisor;
-  h = h / m_resolution_divisor;
-
   m_color.resize(w * h);
 
   AppBase::on_resize(w, h);
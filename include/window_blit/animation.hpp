@@ -0,0 +1,102 @@
+#pragma once
+
+#ifndef WINDOW_BLIT_ANIMATION_HPP_INCLUDED
+#define WINDOW_BLIT_ANIMATION_HPP_INCLUDED
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace window_blit {
+
+class AppFactoryBase;
+
+/// @brief A pose of the camera at a point in time, in the terms of the first
+/// person camera that the window normally controls.
+struct CameraKeyframe final
+{
+  /// @brief The time of the keyframe, in seconds.
+  double time = 0;
+
+  glm::vec3 position = glm::vec3(0, 0, 0);
+
+  /// @brief The rotation about the vertical axis, in degrees.
+  float yaw = 0;
+
+  /// @brief The rotation about the horizontal axis, in degrees, applied before the yaw.
+  float pitch = 0;
+};
+
+/// @brief Options for @ref run_animation.
+struct AnimationOptions final
+{
+  /// @brief The resolution of the output images.
+  int width = 640;
+
+  int height = 480;
+
+  /// @brief The number of frames per second of animation time.
+  float frame_rate = 30;
+
+  /// @brief The printf pattern of the output files, which is passed the index
+  /// of the frame, starting at zero. The images are written as PNG files.
+  const char* output_pattern = "frame_%04d.png";
+
+  /// @brief The highest number of calls to @ref AppBase::render for each
+  /// frame, so that apps that never converge still finish each frame. Zero or
+  /// less means no limit, in which case each frame is rendered until it
+  /// converges. Apps that may never converge must not be run without a limit.
+  int max_pass_count = 10000;
+
+  /// @brief The number of frames that are rendered at the same time, each by
+  /// an app of its own. The apps are all created up front, so each of them
+  /// needs its own memory. Zero or less means one.
+  int frame_thread_count = 1;
+
+  /// @brief The number of threads that each app renders the pixels of a frame
+  /// with, as returned by @ref AppBase::get_pixel_thread_count. Zero or less
+  /// divides the hardware threads evenly between the frame threads.
+  int pixel_thread_count = 0;
+
+  /// @brief Whether to print the progress and the time that the frames took
+  /// to the standard output.
+  bool print_statistics = false;
+};
+
+/// @brief Reads camera keyframes from a text file.
+///
+/// @details Each line holds the time, position, yaw and pitch of one keyframe,
+/// as in "0.5 1 0 -2 90 0". Empty lines and lines starting with '#' are
+/// ignored. The times must increase from one keyframe to the next.
+///
+/// @return False, after printing the reason, if the file could not be read or
+/// is malformed.
+bool
+load_camera_keyframes(const char* path, std::vector<CameraKeyframe>& keyframes);
+
+/// @brief Renders a camera path to a sequence of images, without a window.
+///
+/// @details The app must derive from @ref AppBase. Each frame is rendered the
+/// way @ref run_headless renders its only frame: on the CPU, at the given
+/// resolution, until it converges or the pass limit is reached, and written
+/// with the display transform applied. Before each frame the camera is moved
+/// to the pose along the keyframes at the time of the frame, interpolated
+/// with a Catmull-Rom spline, and @ref AppBase::on_camera_change is called,
+/// followed by @ref AppBase::on_frame_seed. The yaw turns the short way
+/// between keyframes, so 359 to 1 degrees is a turn of two degrees. The frames
+/// span from the first keyframe to the last one.
+///
+/// With more than one frame thread, @ref AppBase::render of the different
+/// apps is called from different threads at the same time, so any data that
+/// the apps share must be safe to read concurrently.
+///
+/// @return EXIT_SUCCESS, or EXIT_FAILURE if the app could not be run or an
+/// image could not be written.
+int
+run_animation(AppFactoryBase&& app_factory,
+              const std::vector<CameraKeyframe>& keyframes,
+              const AnimationOptions& options = AnimationOptions());
+
+} // namespace window_blit
+
+#endif // WINDOW_BLIT_ANIMATION_HPP_INCLUDED
@@ -7,6 +7,8 @@
 
 #include <GLFW/glfw3.h>
 
+#include <memory>
+
 namespace window_blit {
 
 class App
@@ -28,6 +30,28 @@ public:
 
   virtual void on_resize(int w, int h) = 0;
 
+  virtual void on_window_resize(int w, int h);
+
+  /// Indicates whether there is nothing to draw until the next event, in
+  /// which case the window waits for events instead of redrawing every frame.
+  virtual bool is_idle();
+
+  /// Gets how long the window may wait for events before drawing the next
+  /// frame, in seconds. Zero means that frames are drawn continuously and
+  /// infinity that a frame is only drawn when an event arrives. The default
+  /// is based on @ref is_idle.
+  virtual double get_event_timeout();
+
+  /// Indicates whether the frame drawn by @ref on_frame is shown. If not, the
+  /// window is neither drawn nor swapped, but @ref on_frame is still called
+  /// for work done in the background. The default is whether the window is
+  /// visible and not minimized.
+  virtual bool is_presenting();
+
+  virtual void on_iconify(bool iconified);
+
+  virtual void on_focus(bool focused);
+
 protected:
   GLFWwindow* get_glfw_window() noexcept;
 
@@ -53,6 +77,27 @@ public:
   }
 };
 
+/// Creates apps that are passed data shared with the other apps of the
+/// process, such as a scene that several windows show different views of.
+/// The constructor of the app must take the window and a shared pointer to
+/// the data.
+template<typename DerivedApp, typename SharedData>
+class SharedAppFactory final : public AppFactoryBase
+{
+public:
+  explicit SharedAppFactory(std::shared_ptr<SharedData> shared_data)
+    : m_shared_data(std::move(shared_data))
+  {}
+
+  App* create_app(GLFWwindow* window) override
+  {
+    return new DerivedApp(window, m_shared_data);
+  }
+
+private:
+  std::shared_ptr<SharedData> m_shared_data;
+};
+
 } // namespace window_blit
 
 #endif // WINDOW_BLIT_APP_HPP_INCLUDED
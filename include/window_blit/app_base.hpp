@@ -4,23 +4,141 @@
 #define WINDOW_BLIT_RT_APP_HPP_INCLUDED
 
 #include <window_blit/app.hpp>
+#include <window_blit/buffer_pool.hpp>
+#include <window_blit/display_transform.hpp>
 
 #include <glm/glm.hpp>
 
+#include <cstddef>
+#include <vector>
+
 namespace window_blit {
 
 class AppBaseImpl;
 
+struct AnimationOptions;
+
+struct CameraKeyframe;
+
+struct HeadlessOptions;
+
+/// @brief A framebuffer that can be written to directly, in driver owned
+/// memory that the GPU transfers the texture from.
+struct MappedFramebuffer final
+{
+  /// @brief The first pixel of the first row, or null if the framebuffer could
+  /// not be mapped. Each pixel is three floats (red, green and blue), like the
+  /// images passed to @ref AppBase::load_rgb.
+  float* rgb = nullptr;
+
+  int width = 0;
+
+  int height = 0;
+
+  /// @brief The number of bytes from the start of one row to the start of the next.
+  std::size_t pitch = 0;
+
+  float* get_row(int y) const noexcept
+  {
+    return reinterpret_cast<float*>(reinterpret_cast<unsigned char*>(rgb) + (pitch * std::size_t(y)));
+  }
+};
+
+/// @brief The formats that floating point images can be uploaded to the GPU in.
+enum class UploadFormat
+{
+  /// @brief 32-bit floats, 12 bytes per pixel. This is lossless.
+  rgb32f,
+  /// @brief 32-bit floats padded to 16 bytes per pixel, which some drivers
+  /// transfer faster than the unpadded layout.
+  rgba32f,
+  /// @brief 16-bit floats, 6 bytes per pixel.
+  rgb16f,
+  /// @brief 16-bit floats padded to 8 bytes per pixel.
+  rgba16f,
+  /// @brief Three 9-bit mantissas and a shared 5-bit exponent, 4 bytes per pixel.
+  rgb9_e5,
+  /// @brief 8-bit RGBA, 4 bytes per pixel, with the sample weight, tone
+  /// mapping and sRGB conversion applied on the CPU instead of by the shader.
+  /// This suits software rendered or remote contexts, where both the upload
+  /// and the fragment shading are slow. Changes to the display settings only
+  /// take effect with the next upload.
+  display_rgba8,
+  /// @brief The fastest of the above on the current driver, as measured the
+  /// first time the application runs on it. This may be one of the lossy
+  /// formats, so it has to be chosen explicitly.
+  automatic
+};
+
+/// @brief What to do while the window cannot be seen or is not being used.
+enum class BackgroundPolicy
+{
+  /// @brief Render and present as usual.
+  keep_running,
+  /// @brief Stop rendering, so that the window uses no CPU time at all.
+  pause,
+  /// @brief Render and present at a low frame rate, set with @ref
+  /// AppBase::set_throttled_frame_rate.
+  throttle,
+  /// @brief Keep rendering progressively, but do not call @ref
+  /// AppBase::finish_frame or present anything until the window is back in
+  /// the foreground. Applications that override @ref AppBase::render instead
+  /// of @ref AppBase::render_slice keep rendering, but with a render thread
+  /// their frames are not uploaded.
+  accumulate
+};
+
 class AppBase : public App
 {
 public:
+  /// @param window The window to draw in, or null if the app is run by @ref
+  /// run_headless or @ref run_offscreen.
   AppBase(GLFWwindow* window);
 
   AppBase(const AppBase&) = delete;
 
   virtual ~AppBase();
 
-  virtual void render(GLuint texture_id, int w, int h) = 0;
+  /// @brief Renders a frame and uploads it to the texture.
+  ///
+  /// @details Applications either override this to render each frame in one
+  /// call, or override @ref render_slice and @ref finish_frame to render
+  /// progressively. The default calls @ref render_slice until the frame budget
+  /// is spent, and then calls @ref finish_frame.
+  virtual void render(GLuint texture_id, int w, int h);
+
+  /// @brief Does one slice of progressive rendering work, such as adding
+  /// samples to an image that converges over time.
+  ///
+  /// @details The amount of work is chosen by measuring how long previous
+  /// slices took per unit, so that the frame budget is filled without being
+  /// overrun. The first slice of each frame is always done, even if it does not
+  /// fit, so that the image keeps converging when the budget is too small.
+  ///
+  /// @param w The width of the window, as passed to @ref render.
+  ///
+  /// @param h The height of the window, as passed to @ref render.
+  ///
+  /// @param work The number of units of work to do. What a unit is is up to
+  /// the application, but the cost of each unit should be about the same, for
+  /// example one sample per pixel.
+  ///
+  /// @return True if there is more work to do, false if the image has
+  /// converged. Returning false ends the frame and calls @ref set_converged.
+  virtual bool render_slice(int w, int h, int work);
+
+  /// @brief Called after the slices of a frame, to upload the image with one
+  /// of the load or map functions.
+  virtual void finish_frame(GLuint texture_id, int w, int h);
+
+  /// @brief Sets how much time the slices of each frame may take.
+  ///
+  /// @details The default is a 60th of a second. Keep in mind that uploading
+  /// and drawing the image also takes time, so a budget that matches the
+  /// display rate may drop every other frame.
+  ///
+  /// @param seconds The time budget of a frame, in seconds.
+  virtual void set_frame_budget(float seconds);
 
   virtual void on_frame() override;
 
@@ -30,8 +148,51 @@ public:
 
   virtual void on_resize(int w, int h) override;
 
+  /// @brief Invalidates the image. @ref on_resize is then called with the
+  /// scaled size of the window, right before the next call to @ref render and
+  /// on the same thread.
+  virtual void on_window_resize(int w, int h) override;
+
+  /// @brief Indicates whether the image has converged and the camera is not
+  /// moving, so that the window only redraws when an event arrives.
+  virtual bool is_idle() override;
+
+  /// @brief Gets the event timeout of the current background policy.
+  virtual double get_event_timeout() override;
+
+  /// @brief Indicates whether the window is shown and its background policy
+  /// presents frames, which @ref BackgroundPolicy::pause and @ref
+  /// BackgroundPolicy::accumulate do not.
+  virtual bool is_presenting() override;
+
+  virtual void on_iconify(bool iconified) override;
+
+  virtual void on_focus(bool focused) override;
+
+  /// @brief Sets what to do while the window is minimized or hidden. The
+  /// default is @ref BackgroundPolicy::pause.
+  virtual void set_minimized_policy(BackgroundPolicy policy);
+
+  /// @brief Sets what to do while the window is visible but does not have the
+  /// input focus. The default is @ref BackgroundPolicy::keep_running.
+  virtual void set_unfocused_policy(BackgroundPolicy policy);
+
+  /// @brief Sets the frame rate of @ref BackgroundPolicy::throttle. The default is five.
+  virtual void set_throttled_frame_rate(float frames_per_second);
+
   virtual void on_camera_change();
 
+  /// @brief Called by @ref run_animation before each frame, right after @ref
+  /// on_camera_change, and on the thread that renders the frame.
+  ///
+  /// @details Frames are handed to whichever app is free, so apps that render
+  /// with random numbers should seed their generators from @p seed here. Each
+  /// frame then comes out the same, no matter which app renders it or how
+  /// many frames are rendered at once. The default does nothing.
+  ///
+  /// @param seed The index of the frame in the animation.
+  virtual void on_frame_seed(unsigned int seed);
+
   virtual glm::vec3 get_camera_position() const;
 
   virtual glm::mat3 get_camera_rotation_transform() const;
@@ -63,16 +224,238 @@ public:
   /// @param srgb_mask The level at which to use the sRGB conversion in the final image.
   virtual void set_srgb(float srgb_mask);
 
+  /// @brief Gets the current sample weight, tone mapping and sRGB settings,
+  /// for exporting images that look the same as the window with @ref
+  /// encode_display_rgba8.
+  DisplayTransform get_display_transform() const;
+
+  /// @brief Sets whether the resolution that is rendered at is scaled
+  /// automatically, so that frames take about the target frame time.
+  ///
+  /// @details The size passed to @ref render and @ref on_resize is then a
+  /// fraction of the window size, which changes over time, and the image is
+  /// stretched to fill the window. The scale is continuous rather than an
+  /// integer divisor, but it only changes once the frame time has been off
+  /// by more than a few percent, since every change means a resize. When
+  /// rendering progressively with @ref render_slice, frames always fill their
+  /// budget, so the time of one unit of work is held to the target instead.
+  /// This is disabled by default.
+  virtual void set_dynamic_resolution(bool enabled);
+
+  /// @brief Sets how long frames should take when the resolution is dynamic.
+  /// The default is a 60th of a second.
+  virtual void set_target_frame_time(float seconds);
+
+  /// @brief Sets the scale of the resolution while it is not dynamic.
+  ///
+  /// @param scale The fraction of the window width and height to render at,
+  /// which is one by default.
+  virtual void set_resolution_scale(float scale);
+
+  /// @brief Gets the fraction of the window size that the most recent frame was rendered at.
+  float get_resolution_scale() const;
+
+  /// @brief Gets the number of threads to render the pixels of a frame with.
+  ///
+  /// @details This is zero, which leaves the number of threads up to the app,
+  /// unless the app is run by @ref run_animation. That renders several frames
+  /// at once and divides the hardware threads between them, so apps that
+  /// render in parallel should then use no more threads than this, for example
+  /// with the num_threads clause of OpenMP.
+  int get_pixel_thread_count() const;
+
+  /// @brief Sets the format that floating point images are converted to before
+  /// being uploaded by @ref load_rgb.
+  ///
+  /// @details The smaller formats reduce the upload bandwidth, at the cost of
+  /// precision that is usually not visible after tone mapping. The sample
+  /// weight is applied before the conversion, so that large accumulated values
+  /// stay within the range of the format. The default is the lossless @ref
+  /// UploadFormat::rgb32f. 8-bit images are always uploaded in the layout
+  /// measured to be the fastest.
+  virtual void set_upload_format(UploadFormat format);
+
+  /// @brief Sets whether or not images are uploaded on a background thread.
+  ///
+  /// @details When enabled, @ref load_rgb copies the image on the calling
+  /// thread and returns, while a thread with a shared context uploads the copy.
+  /// The copy still takes time on the calling thread, but the image may be
+  /// overwritten as soon as @ref load_rgb returns. The image is then
+  /// presented on a later frame, once the upload completes. This only applies
+  /// to whole images passed to @ref load_rgb, the other upload functions still
+  /// upload on the render thread. With @ref set_threaded_render, the frames of
+  /// the render thread are handed to the upload thread without another copy.
+  /// It is ignored if the context does not support fences.
+  virtual void set_async_upload(bool enabled);
+
+  /// @brief Sets whether or not @ref render is called on a thread of its own.
+  ///
+  /// @details When enabled, @ref render is called over and over on a render
+  /// thread, while the window thread keeps handling events and drawing the
+  /// newest finished image at the display rate. The load and map functions
+  /// called from @ref render copy the image into one of three buffers, which
+  /// is handed over to the window thread without locking once @ref render
+  /// returns. Images that are finished faster than they are displayed are
+  /// skipped.
+  ///
+  /// On the render thread, the texture passed to @ref render is zero and no GL
+  /// calls may be made. @ref on_resize and @ref on_camera_change are called
+  /// there too, between calls to @ref render. Everything else, such as @ref
+  /// render_imgui, is still called on the window thread, so any state that it
+  /// shares with @ref render must be synchronized.
+  ///
+  /// The render threads of all of the windows in the process share a pool of
+  /// workers, see @ref set_render_priority. The thread is started on the next
+  /// frame and stopped by @ref on_close, so overrides of @ref on_close must
+  /// call it. This must be called from the window thread.
+  virtual void set_threaded_render(bool enabled);
+
+  /// @brief Sets the share of the render workers that this window gets while
+  /// rendering on a thread, relative to the other windows.
+  ///
+  /// @details The workers are fair: a window with twice the priority of
+  /// another gets twice the render time, as long as both have work to do.
+  /// Windows that are converged or paused do not take up any time. The default is one.
+  virtual void set_render_priority(float priority);
+
 protected:
+  /// @brief Reports that the image will not change until it is invalidated,
+  /// either because it has converged or because nothing it depends on changed.
+  ///
+  /// @details Must be called from @ref render. Once the image is converged,
+  /// @ref render is no longer called, nothing is uploaded and the window waits
+  /// for events instead of redrawing every frame, so that an idle window uses
+  /// next to no CPU time. Resizing the window, moving the camera and changing
+  /// the display settings invalidate the image.
+  void set_converged();
+
+  /// @brief Makes @ref render get called again after @ref set_converged, for
+  /// example when a setting that the image depends on was changed.
+  ///
+  /// @details This may be called from any thread.
+  void invalidate();
+
+  /// @brief Gets a pool for the buffers that the application renders into.
+  ///
+  /// @details Resizes are coalesced, so that @ref on_resize is called at most
+  /// once per frame, but the size may still change on many frames in a row
+  /// while the window is being dragged. Buffers that are a @ref PooledBuffer
+  /// of this pool only allocate when they grow past their size class, so
+  /// most of those resizes do not allocate at all.
+  BufferPool& get_buffer_pool() noexcept;
+
   void load_rgb(const float* rgb, int w, int h, GLuint texture_id);
 
   void load_rgb(const glm::vec3* rgb, int w, int h, GLuint texture_id);
 
   void load_rgb(const unsigned char* rgb, int w, int h, GLuint texture_id);
 
+  /// @brief Uploads an image with four floats per pixel, of which the fourth is ignored.
+  ///
+  /// @details This matches how GPUs store floating point textures, so the
+  /// driver can copy the pixels without repacking them. Each pixel is 16 bytes
+  /// and rows are tightly packed, so if the image starts on a 16 byte boundary
+  /// (for example a std::vector of glm::aligned_vec4), every pixel can be
+  /// written with an aligned vector store. The upload format still applies,
+  /// with the padded variant of a format being used where there is one.
+  void load_rgba(const float* rgba, int w, int h, GLuint texture_id);
+
+  void load_rgba(const glm::vec4* rgba, int w, int h, GLuint texture_id);
+
+  /// @brief Uploads a band of rows of an image that have finished rendering.
+  ///
+  /// @details The upload starts right away and is performed by the GPU while
+  /// the remaining rows are rendered, so streaming an image in bands shortens
+  /// the time until the whole frame can be presented. This must be called on
+  /// the thread that called @ref render.
+  ///
+  /// @param rgb The whole image, which is @p w by @p h pixels.
+  ///
+  /// @param y The first row of the band.
+  ///
+  /// @param row_count The number of rows in the band.
+  void load_rgb_rows(const float* rgb, int w, int h, int y, int row_count, GLuint texture_id);
+
+  void load_rgb_rows(const glm::vec3* rgb, int w, int h, int y, int row_count, GLuint texture_id);
+
+  void load_rgb_rows(const unsigned char* rgb, int w, int h, int y, int row_count, GLuint texture_id);
+
+  /// @brief Maps a framebuffer that the image can be written into, avoiding
+  /// the copy done by @ref load_rgb.
+  ///
+  /// @details When the context supports it, the memory is persistently mapped
+  /// and the GPU transfers the texture straight out of it. The pixels are
+  /// uploaded by @ref unmap_framebuffer, or once @ref render returns if it was
+  /// not called. The sample weight is applied by the shader, like with the
+  /// 32-bit float upload format.
+  ///
+  /// @return The framebuffer. Its pointer is null if it could not be mapped.
+  MappedFramebuffer map_framebuffer(int w, int h);
+
+  /// @brief Uploads the pixels written to the framebuffer from @ref
+  /// map_framebuffer. The framebuffer may not be written to afterwards.
+  void unmap_framebuffer();
+
+  /// @brief Marks a rectangle of an image as changed, so that only the changed
+  /// parts of the image are uploaded.
+  ///
+  /// @details The rectangles given during @ref render are merged and uploaded
+  /// once it returns. They are read straight out of @p rgb, which must stay
+  /// valid until then. Passing a different image uploads the rectangles of the
+  /// previous one first. If the texture does not yet have the size of the image,
+  /// the whole image is uploaded instead.
+  ///
+  /// @param rgb The whole image, which is @p w by @p h pixels.
+  void load_rgb_region(const float* rgb, int w, int h, int x, int y, int region_w, int region_h, GLuint texture_id);
+
+  void load_rgb_region(const glm::vec3* rgb,
+                       int w,
+                       int h,
+                       int x,
+                       int y,
+                       int region_w,
+                       int region_h,
+                       GLuint texture_id);
+
+  void load_rgb_region(const unsigned char* rgb,
+                       int w,
+                       int h,
+                       int x,
+                       int y,
+                       int region_w,
+                       int region_h,
+                       GLuint texture_id);
+
 private:
   friend AppBaseImpl;
 
+  friend int run_headless(AppFactoryBase&&, const HeadlessOptions&);
+
+  friend int run_offscreen(AppFactoryBase&&, const HeadlessOptions&);
+
+  friend int run_animation(AppFactoryBase&&, const std::vector<CameraKeyframe>&, const AnimationOptions&);
+
+  /// @brief Renders a frame without a window, for @ref run_headless and @ref
+  /// run_offscreen. Without a context, the frame goes into a framebuffer on
+  /// the CPU, otherwise it is drawn into the bound framebuffer.
+  ///
+  /// @return Whether the image has converged.
+  bool render_headless(int w, int h);
+
+  /// @brief Gets the last image from @ref render_headless, as 8-bit RGBA
+  /// pixels with the display transform applied.
+  ///
+  /// @return False if no image was rendered, or if it was drawn with a context.
+  bool get_headless_image(std::vector<unsigned char>& rgba, int& w, int& h);
+
+  /// @brief Moves the camera to a keyframe for @ref run_animation, invalidates
+  /// the image and passes the index of the frame to @ref on_frame_seed.
+  void set_camera_keyframe(const CameraKeyframe& keyframe, int frame);
+
+  /// @brief Sets what @ref get_pixel_thread_count returns. Zero or less means
+  /// that the app picks the number of threads itself.
+  void set_pixel_thread_count(int thread_count);
+
   AppBaseImpl* m_impl = nullptr;
 };
 
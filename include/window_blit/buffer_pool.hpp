@@ -0,0 +1,142 @@
+#pragma once
+
+#ifndef WINDOW_BLIT_BUFFER_POOL_HPP_INCLUDED
+#define WINDOW_BLIT_BUFFER_POOL_HPP_INCLUDED
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <type_traits>
+
+namespace window_blit {
+
+/// @brief Hands out memory blocks in a fixed set of size classes, and keeps
+/// released blocks around to be handed out again.
+///
+/// @details Each power of two is split into four size classes, so a block is
+/// at most a quarter larger than requested. When a buffer grows a little at a
+/// time, such as while a window is being resized, most of the new sizes still
+/// fit in the block it already has, and the others are likely served from a
+/// block released earlier. This may be used from any thread.
+class BufferPool final
+{
+public:
+  /// @param max_cached_size The number of bytes of released blocks to keep
+  /// around. Blocks released beyond that are freed.
+  explicit BufferPool(std::size_t max_cached_size = std::size_t(256) << 20);
+
+  BufferPool(const BufferPool&) = delete;
+
+  ~BufferPool();
+
+  /// @brief Gets a block of at least @p size bytes, aligned to 64 bytes.
+  ///
+  /// @param capacity Assigned the actual size of the block, which must be
+  /// passed back to @ref release.
+  ///
+  /// @return The block, or null if @p size is zero or it could not be allocated.
+  void* acquire(std::size_t size, std::size_t& capacity);
+
+  /// @brief Returns a block to the pool.
+  void release(void* block, std::size_t capacity);
+
+  /// @brief Gets the size of the smallest size class that fits @p size bytes.
+  static std::size_t get_size_class(std::size_t size) noexcept;
+
+private:
+  std::mutex m_mutex;
+
+  /// Released blocks, by capacity.
+  std::multimap<std::size_t, void*> m_free_blocks;
+
+  std::size_t m_cached_size = 0;
+
+  std::size_t m_max_cached_size = 0;
+};
+
+/// @brief A buffer of trivially copyable elements, whose memory comes from a
+/// @ref BufferPool.
+///
+/// @details Unlike a std::vector, resizing keeps the existing block whenever
+/// the new size fits into it, and the elements are left uninitialized. The
+/// elements are kept along with the block, within the new size. They are
+/// undefined once a larger block is taken, which suits frame buffers that are
+/// cleared right after being resized anyway.
+template<typename T>
+class PooledBuffer final
+{
+  static_assert(std::is_trivially_copyable<T>::value, "Pooled elements are not constructed or destroyed.");
+
+public:
+  explicit PooledBuffer(BufferPool& pool)
+    : m_pool(&pool)
+  {}
+
+  PooledBuffer(const PooledBuffer&) = delete;
+
+  PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+  ~PooledBuffer() { m_pool->release(m_data, m_capacity); }
+
+  /// @brief Changes the number of elements, getting a larger block from the
+  /// pool if the current one is too small.
+  ///
+  /// @return False if a block could not be allocated, in which case the buffer is empty.
+  bool resize(std::size_t size)
+  {
+    if ((size * sizeof(T)) > m_capacity) {
+
+      m_pool->release(m_data, m_capacity);
+
+      m_capacity = 0;
+
+      m_data = static_cast<T*>(m_pool->acquire(size * sizeof(T), m_capacity));
+
+      if (!m_data) {
+        m_size = 0;
+        return false;
+      }
+    }
+
+    m_size = size;
+
+    return true;
+  }
+
+  std::size_t size() const noexcept { return m_size; }
+
+  /// @brief The number of elements that fit into the current block.
+  std::size_t capacity() const noexcept { return m_capacity / sizeof(T); }
+
+  bool empty() const noexcept { return !m_size; }
+
+  T* data() noexcept { return m_data; }
+
+  const T* data() const noexcept { return m_data; }
+
+  T& operator[](std::size_t index) noexcept { return m_data[index]; }
+
+  const T& operator[](std::size_t index) const noexcept { return m_data[index]; }
+
+  T* begin() noexcept { return m_data; }
+
+  T* end() noexcept { return m_data + m_size; }
+
+  const T* begin() const noexcept { return m_data; }
+
+  const T* end() const noexcept { return m_data + m_size; }
+
+private:
+  BufferPool* m_pool;
+
+  T* m_data = nullptr;
+
+  std::size_t m_size = 0;
+
+  /// The size of the block, in bytes.
+  std::size_t m_capacity = 0;
+};
+
+} // namespace window_blit
+
+#endif // WINDOW_BLIT_BUFFER_POOL_HPP_INCLUDED
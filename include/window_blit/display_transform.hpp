@@ -0,0 +1,57 @@
+#pragma once
+
+#ifndef WINDOW_BLIT_DISPLAY_TRANSFORM_HPP_INCLUDED
+#define WINDOW_BLIT_DISPLAY_TRANSFORM_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+namespace window_blit {
+
+/// @brief The parameters of the transform from the rendered values to the
+/// displayed colors, as set on @ref AppBase.
+struct DisplayTransform final
+{
+  /// @brief Multiplied with each channel before anything else.
+  float sample_weight = 1;
+
+  /// @brief How much of the tone mapped color to use, from zero to one.
+  float tone_mapping = 1;
+
+  /// @brief How much of the sRGB encoded color to use, from zero to one.
+  float srgb = 1;
+};
+
+/// @brief Applies the display transform to RGB pixels and encodes them as
+/// 8-bit RGBA pixels, with an alpha of 255, which are the colors that a window
+/// shows for the same pixels.
+///
+/// @details This is the same math as the fragment shader that draws the
+/// window: the sample weight, then the Hable tone mapping and then the sRGB
+/// encoding, with the last two blended in by their amounts. The power
+/// functions are approximated well below the precision of the output, so the
+/// result matches the shader to within one step of the 8-bit encoding, which
+/// is as close as two GPUs match each other. AVX2 is used if the CPU supports
+/// it, otherwise SSE2 on x86 and plain code elsewhere. NEON is used on 64-bit
+/// ARM only if the library is built with WINDOWBLIT_NEON, since that code has
+/// not been checked against the shader on ARM hardware yet.
+/// Large images are split into chunks that are encoded in parallel, on a pool
+/// of threads shared by the process.
+///
+/// @param rgb The pixels, with the top row first if they are to be written
+/// to an image file.
+///
+/// @param rgba Receives the encoded pixels, four bytes each.
+///
+/// @param channel_count The number of floats per source pixel, which is four
+/// for RGBA pixels. Only the first three are used.
+void
+encode_display_rgba8(const float* rgb,
+                     std::uint8_t* rgba,
+                     std::size_t pixel_count,
+                     const DisplayTransform& transform,
+                     int channel_count = 3);
+
+} // namespace window_blit
+
+#endif // WINDOW_BLIT_DISPLAY_TRANSFORM_HPP_INCLUDED
@@ -3,12 +3,82 @@
 #ifndef WINDOW_BLIT_GLFW_HPP_INCLUDED
 #define WINDOW_BLIT_GLFW_HPP_INCLUDED
 
+#include <vector>
+
 namespace window_blit {
 
 class AppFactoryBase;
 
+/// @brief How finished frames are presented.
+enum class PresentMode
+{
+  /// @brief Waits for the vertical blank, which limits the frame rate to the refresh rate.
+  vsync,
+  /// @brief Presents right away, which may tear. Useful for measuring throughput.
+  immediate,
+  /// @brief Waits for the vertical blank, unless the frame is late, in which
+  /// case it is presented right away. Falls back to @ref vsync if the driver
+  /// does not support it.
+  adaptive
+};
+
+/// @brief Options for @ref run_glfw_window.
+struct RunOptions final
+{
+  PresentMode present_mode = PresentMode::vsync;
+
+  /// @brief The highest number of frames per second, enforced by sleeping
+  /// between frames. Zero or less means no limit. This is useful for keeping
+  /// many windows on one machine from competing for the CPU.
+  float max_frame_rate = 0;
+
+  /// @brief The initial size of the window, in screen coordinates.
+  int width = 640;
+
+  int height = 480;
+
+  const char* title = "";
+
+  /// @brief The version of the OpenGL context to request. Newer versions
+  /// must be compatibility profiles, since the shaders are GLSL 1.20.
+  int context_version_major = 2;
+
+  int context_version_minor = 1;
+
+  /// @brief The number of workers that the render threads of all windows
+  /// share. One is usually best, since renderers tend to parallelize each
+  /// frame on their own, and the workers take turns fairly between windows.
+  /// Workers that an earlier call started are kept, even if this is smaller.
+  int render_thread_count = 1;
+
+  /// @brief A file to record the key, cursor button, cursor motion and resize
+  /// events of the windows to, along with the frames that they arrived
+  /// before. Null means that nothing is recorded.
+  const char* record_path = nullptr;
+
+  /// @brief A recording to feed to the windows instead of their own input,
+  /// one recorded frame per frame, with the camera moving by the recorded
+  /// times rather than the real ones. Recorded resizes set the size that is
+  /// rendered at in the frame they were recorded before, and the windows are
+  /// resized to match only for show. The windows close once the recording
+  /// ends, and the frame times are then printed to the standard output, so
+  /// that two builds can be compared on the same session. Escape still closes
+  /// the windows. Recordings can also be replayed by @ref run_headless. Null
+  /// means that the windows take their input as usual.
+  const char* replay_path = nullptr;
+};
+
+int
+run_glfw_window(AppFactoryBase&& app_factory, const RunOptions& options = RunOptions());
+
+/// @brief Opens a window for each factory and runs them until the first one is closed.
+///
+/// @details The windows share their OpenGL objects, and any threaded
+/// rendering is scheduled on one pool of workers. ImGui is only drawn over the
+/// first window. The other windows can be closed on their own. To share data
+/// such as a scene between the apps, use a @ref SharedAppFactory.
 int
-run_glfw_window(AppFactoryBase&& app_factory);
+run_glfw_windows(const std::vector<AppFactoryBase*>& app_factories, const RunOptions& options = RunOptions());
 
 } // namespace window_blit
 
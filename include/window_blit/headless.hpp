@@ -0,0 +1,88 @@
+#pragma once
+
+#ifndef WINDOW_BLIT_HEADLESS_HPP_INCLUDED
+#define WINDOW_BLIT_HEADLESS_HPP_INCLUDED
+
+namespace window_blit {
+
+class AppFactoryBase;
+
+/// @brief Options for @ref run_headless and @ref run_offscreen.
+struct HeadlessOptions final
+{
+  /// @brief The resolution of the output image.
+  int width = 640;
+
+  int height = 480;
+
+  /// @brief The highest number of frames to render, so that apps that never
+  /// converge still stop. Zero or less means no limit, in which case rendering
+  /// only stops once the image converges or the replayed recording ends. Apps
+  /// that may never converge must not be run without a limit.
+  int max_frame_count = 10000;
+
+  /// @brief Whether to stop once the image has converged, as reported with
+  /// @ref AppBase::set_converged. Turning this off renders exactly @ref
+  /// max_frame_count frames, which is useful for benchmarks. It can only be
+  /// turned off along with the frame limit when a recording is replayed.
+  bool stop_when_converged = true;
+
+  /// @brief The PNG file to write the last frame to, with the display
+  /// transform applied as it would be in a window. Null or empty means that
+  /// nothing is written.
+  const char* output_path = "frame.png";
+
+  /// @brief Whether to print the number of frames and how long they took to
+  /// the standard output once done.
+  bool print_statistics = false;
+
+  /// @brief An input recording made with @ref RunOptions::record_path to
+  /// feed to the app, one recorded frame per rendered frame. Only the input
+  /// of the first window is replayed, and its resizes change the resolution.
+  /// Frames are then rendered until the recording ends or @ref
+  /// max_frame_count is reached, whether or not the image converges. Null or
+  /// empty means that there is no input.
+  const char* replay_path = nullptr;
+};
+
+/// @brief Renders frames of an app without a window, a GL context or GLFW.
+///
+/// @details The app must derive from @ref AppBase. It is constructed with a
+/// null window, and @ref AppBase::render is called at the given resolution
+/// until one of the stopping conditions of the options is met. Everything that
+/// the load and map functions upload is copied into a framebuffer on the CPU
+/// instead, like with @ref AppBase::set_threaded_render, so the texture passed
+/// to @ref AppBase::render is zero and no GL calls may be made. ImGui,
+/// background policies, threaded rendering and asynchronous uploads do not
+/// apply, and neither do dynamic resolution and the resolution scale. There is
+/// no input, unless a recording is replayed. @ref AppBase::on_close is called
+/// before the app is destroyed.
+///
+/// @return EXIT_SUCCESS, or EXIT_FAILURE if the options would never stop, the
+/// app could not be run or the image could not be written.
+int
+run_headless(AppFactoryBase&& app_factory, const HeadlessOptions& options = HeadlessOptions());
+
+/// @brief Renders frames of an app through the same OpenGL pipeline as a
+/// window, on an offscreen context instead of a window.
+///
+/// @details The context is created with EGL, without a display server, which
+/// works with Mesa's llvmpipe on machines without a GPU. This requires the
+/// library to be built with WINDOWBLIT_EGL. The app is constructed with a null
+/// window, like with @ref run_headless, except that the images are uploaded
+/// and drawn with the display shader into a framebuffer object of the given
+/// size, just as they would be in a window. Each frame is read back through a
+/// ring of pixel buffers, without waiting for the GPU, so the frame times
+/// include the whole pipeline. ImGui, background policies, threaded rendering,
+/// asynchronous uploads, dynamic resolution and the resolution scale do not
+/// apply, and there is no input unless a recording is replayed.
+///
+/// @return EXIT_SUCCESS, or EXIT_FAILURE if the options would never stop, the
+/// context could not be created, the app could not be run or the image could
+/// not be written.
+int
+run_offscreen(AppFactoryBase&& app_factory, const HeadlessOptions& options = HeadlessOptions());
+
+} // namespace window_blit
+
+#endif // WINDOW_BLIT_HEADLESS_HPP_INCLUDED
@@ -0,0 +1,213 @@
+#pragma once
+
+#ifndef WINDOW_BLIT_RENDER_TASK_HPP_INCLUDED
+#define WINDOW_BLIT_RENDER_TASK_HPP_INCLUDED
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "window_blit/render_task.hpp requires C++20 coroutines."
+#endif
+
+#include <window_blit/app_base.hpp>
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace window_blit {
+
+/// @brief An image in progress, yielded by a @ref RenderTask to be presented.
+struct FrameProgress final
+{
+  /// @brief The pixels, which must stay valid until the task is resumed again.
+  const float* pixels = nullptr;
+
+  /// @brief Three for RGB pixels, four for RGBA pixels, as with @ref AppBase::load_rgba.
+  int channel_count = 3;
+
+  int width = 0;
+
+  int height = 0;
+
+  /// @brief Passed to @ref AppBase::set_sample_weight, for example one over
+  /// the number of sample passes accumulated so far.
+  float sample_weight = 1;
+};
+
+/// @brief A coroutine that renders an image incrementally, yielding a @ref
+/// FrameProgress after each step, such as a finished set of tiles or one more
+/// sample pass.
+///
+/// @details The coroutine is suspended until first resumed. Finishing the
+/// coroutine means the image has converged, and the last progress that was
+/// yielded stays presented.
+class RenderTask final
+{
+public:
+  struct promise_type final
+  {
+    FrameProgress progress;
+
+    bool has_progress = false;
+
+    std::exception_ptr exception;
+
+    RenderTask get_return_object() { return RenderTask(Handle::from_promise(*this)); }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    std::suspend_always final_suspend() noexcept { return {}; }
+
+    std::suspend_always yield_value(const FrameProgress& value) noexcept
+    {
+      progress = value;
+      has_progress = true;
+      return {};
+    }
+
+    void return_void() noexcept {}
+
+    void unhandled_exception() noexcept { exception = std::current_exception(); }
+  };
+
+  using Handle = std::coroutine_handle<promise_type>;
+
+  RenderTask() = default;
+
+  RenderTask(RenderTask&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, nullptr))
+  {}
+
+  RenderTask& operator=(RenderTask&& other) noexcept
+  {
+    if (this != &other) {
+      destroy();
+      m_handle = std::exchange(other.m_handle, nullptr);
+    }
+    return *this;
+  }
+
+  RenderTask(const RenderTask&) = delete;
+
+  ~RenderTask() { destroy(); }
+
+  explicit operator bool() const noexcept { return static_cast<bool>(m_handle); }
+
+  /// @brief Runs the coroutine until it yields or finishes. Exceptions that
+  /// escape the coroutine are rethrown here.
+  ///
+  /// @return True if the coroutine yielded, false if it has finished.
+  bool resume()
+  {
+    if (!m_handle || m_handle.done())
+      return false;
+
+    m_handle.resume();
+
+    if (m_handle.promise().exception)
+      std::rethrow_exception(std::exchange(m_handle.promise().exception, nullptr));
+
+    return !m_handle.done();
+  }
+
+  /// @brief Gets the most recently yielded progress, or null if there is none yet.
+  const FrameProgress* get_progress() const noexcept
+  {
+    if (!m_handle || !m_handle.promise().has_progress)
+      return nullptr;
+
+    return &m_handle.promise().progress;
+  }
+
+private:
+  explicit RenderTask(Handle handle) noexcept
+    : m_handle(handle)
+  {}
+
+  void destroy() noexcept
+  {
+    if (m_handle)
+      m_handle.destroy();
+
+    m_handle = nullptr;
+  }
+
+private:
+  Handle m_handle;
+};
+
+/// @brief An app that renders with a coroutine instead of overriding @ref
+/// AppBase::render.
+///
+/// @details The coroutine is resumed through @ref AppBase::render_slice, once
+/// per unit of work, so the frame budget decides how many steps are taken
+/// between presentations, and the last progress yielded is presented after
+/// each frame. The coroutine is started again whenever the size changes or
+/// the camera moves, so overrides of @ref on_camera_change must call this
+/// one. The same thread resumes the coroutine and calls those functions,
+/// even with @ref AppBase::set_threaded_render.
+class CoroutineApp : public AppBase
+{
+public:
+  using AppBase::AppBase;
+
+  /// @brief Starts rendering an image of the given size.
+  virtual RenderTask render_async(int w, int h) = 0;
+
+  bool render_slice(int w, int h, int work) override
+  {
+    if (m_restart_requested.exchange(false) || !m_task || (w != m_task_w) || (h != m_task_h)) {
+      m_task = render_async(w, h);
+      m_task_w = w;
+      m_task_h = h;
+    }
+
+    for (int i = 0; i < work; i++) {
+      if (!m_task.resume())
+        return false;
+    }
+
+    return true;
+  }
+
+  void finish_frame(GLuint texture_id, int /* w */, int /* h */) override
+  {
+    const FrameProgress* progress = m_task.get_progress();
+
+    if (!progress || !progress->pixels)
+      return;
+
+    set_sample_weight(progress->sample_weight);
+
+    if (progress->channel_count == 4)
+      load_rgba(progress->pixels, progress->width, progress->height, texture_id);
+    else
+      load_rgb(progress->pixels, progress->width, progress->height, texture_id);
+  }
+
+  void on_camera_change() override { m_restart_requested = true; }
+
+protected:
+  /// @brief Abandons the current coroutine and starts a new one on the next
+  /// frame, for example after changing something the image depends on. This
+  /// may be called from any thread.
+  void restart()
+  {
+    m_restart_requested = true;
+
+    invalidate();
+  }
+
+private:
+  RenderTask m_task;
+
+  std::atomic<bool> m_restart_requested{ false };
+
+  int m_task_w = 0;
+
+  int m_task_h = 0;
+};
+
+} // namespace window_blit
+
+#endif // WINDOW_BLIT_RENDER_TASK_HPP_INCLUDED
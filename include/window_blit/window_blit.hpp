@@ -3,7 +3,11 @@
 #ifndef WINDOW_BLIT_WINDOW_BLIT_HPP_INCLUDED
 #define WINDOW_BLIT_WINDOW_BLIT_HPP_INCLUDED
 
+#include <window_blit/animation.hpp>
 #include <window_blit/app_base.hpp>
+#include <window_blit/buffer_pool.hpp>
+#include <window_blit/display_transform.hpp>
 #include <window_blit/glfw.hpp>
+#include <window_blit/headless.hpp>
 
 #endif // WINDOW_BLIT_WINDOW_BLIT_HPP_INCLUDED
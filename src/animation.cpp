@@ -0,0 +1,341 @@
+#include <window_blit/animation.hpp>
+
+#include <window_blit/app_base.hpp>
+
+#include "stb_image_write.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace window_blit {
+
+namespace {
+
+template<typename T>
+T
+catmull_rom(const T& p0, const T& p1, const T& p2, const T& p3, float t)
+{
+  const float t2 = t * t;
+  const float t3 = t2 * t;
+
+  return 0.5f * ((2.0f * p1) + ((p2 - p0) * t) + (((2.0f * p0) - (5.0f * p1) + (4.0f * p2) - p3) * t2) +
+                 (((3.0f * p1) - p0 - (3.0f * p2) + p3) * t3));
+}
+
+/// Interpolates the camera between keyframes with a Catmull-Rom spline, which
+/// passes through each of the keyframes and has no kinks at them.
+class CameraPath final
+{
+public:
+  /// @param keyframes The keyframes, which must not be empty and must be sorted by time.
+  explicit CameraPath(const std::vector<CameraKeyframe>& keyframes)
+    : m_keyframes(keyframes)
+  {
+    // Each yaw is moved by whole turns to within half a turn of the previous
+    // one, so that the camera turns the short way, as from 359 to 1 degrees.
+    for (std::size_t i = 1; i < m_keyframes.size(); i++) {
+
+      const float previous_yaw = m_keyframes[i - 1].yaw;
+
+      const float delta = m_keyframes[i].yaw - previous_yaw;
+
+      m_keyframes[i].yaw = previous_yaw + (delta - (360.0f * std::round(delta / 360.0f)));
+    }
+  }
+
+  double get_start_time() const { return m_keyframes.front().time; }
+
+  double get_duration() const { return m_keyframes.back().time - m_keyframes.front().time; }
+
+  /// Gets the pose of the camera at a time, which is clamped to the keyframes.
+  CameraKeyframe get_keyframe(double time) const
+  {
+    auto it = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), time, [](double t, const CameraKeyframe& k) {
+      return t < k.time;
+    });
+
+    if (it == m_keyframes.begin())
+      return m_keyframes.front();
+
+    if (it == m_keyframes.end())
+      return m_keyframes.back();
+
+    // The segment is from k1 to k2, and the keyframes on either side of it set the tangents.
+    const std::size_t i2 = std::size_t(it - m_keyframes.begin());
+    const std::size_t i1 = i2 - 1;
+
+    const CameraKeyframe& k0 = m_keyframes[(i1 > 0) ? (i1 - 1) : i1];
+    const CameraKeyframe& k1 = m_keyframes[i1];
+    const CameraKeyframe& k2 = m_keyframes[i2];
+    const CameraKeyframe& k3 = m_keyframes[std::min(i2 + 1, m_keyframes.size() - 1)];
+
+    const float t = float((time - k1.time) / (k2.time - k1.time));
+
+    CameraKeyframe keyframe;
+    keyframe.time = time;
+    keyframe.position = catmull_rom(k0.position, k1.position, k2.position, k3.position, t);
+    keyframe.yaw = catmull_rom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, t);
+    keyframe.pitch = catmull_rom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, t);
+    return keyframe;
+  }
+
+private:
+  std::vector<CameraKeyframe> m_keyframes;
+};
+
+/// Formats the path of the output file of a frame.
+///
+/// @return The path, or an empty string if the pattern is invalid.
+std::string
+format_output_path(const char* pattern, int frame)
+{
+  const int size = std::snprintf(nullptr, 0, pattern, frame);
+
+  if (size <= 0)
+    return std::string();
+
+  std::string path(std::size_t(size), '\0');
+
+  std::snprintf(&path[0], path.size() + 1, pattern, frame);
+
+  return path;
+}
+
+bool
+check_options(const AnimationOptions& options, const std::vector<CameraKeyframe>& keyframes)
+{
+  if ((options.width <= 0) || (options.height <= 0)) {
+    std::cerr << "Invalid animation resolution " << options.width << 'x' << options.height << std::endl;
+    return false;
+  }
+
+  if (!(options.frame_rate > 0)) {
+    std::cerr << "Invalid animation frame rate " << options.frame_rate << std::endl;
+    return false;
+  }
+
+  if (keyframes.empty()) {
+    std::cerr << "The animation has no camera keyframes" << std::endl;
+    return false;
+  }
+
+  for (std::size_t i = 1; i < keyframes.size(); i++) {
+    if (!(keyframes[i].time > keyframes[i - 1].time)) {
+      std::cerr << "The times of the camera keyframes do not increase, at keyframe " << i << std::endl;
+      return false;
+    }
+  }
+
+  // A pattern without a conversion for the frame would write every frame to the same file.
+  const char* pattern = options.output_pattern ? options.output_pattern : "";
+
+  const std::string first_path = format_output_path(pattern, 0);
+
+  if (first_path.empty() || (first_path == format_output_path(pattern, 1))) {
+    std::cerr << "The output pattern '" << pattern << "' does not contain the frame number, as in %04d" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace
+
+bool
+load_camera_keyframes(const char* path, std::vector<CameraKeyframe>& keyframes)
+{
+  std::ifstream file(path);
+
+  if (!file.good()) {
+    std::cerr << "Failed to open '" << path << "'" << std::endl;
+    return false;
+  }
+
+  keyframes.clear();
+
+  std::string line;
+
+  for (int line_number = 1; std::getline(file, line); line_number++) {
+
+    const std::size_t first = line.find_first_not_of(" \t\r");
+
+    if ((first == std::string::npos) || (line[first] == '#'))
+      continue;
+
+    std::istringstream line_stream(line);
+
+    CameraKeyframe keyframe;
+
+    line_stream >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >>
+      keyframe.yaw >> keyframe.pitch;
+
+    std::string rest;
+
+    if (line_stream.fail() || (line_stream >> rest)) {
+      std::cerr << path << ':' << line_number << ": expected the time, position, yaw and pitch of a keyframe"
+                << std::endl;
+      return false;
+    }
+
+    if (!keyframes.empty() && !(keyframe.time > keyframes.back().time)) {
+      std::cerr << path << ':' << line_number << ": the time of a keyframe must be after the previous one"
+                << std::endl;
+      return false;
+    }
+
+    keyframes.emplace_back(keyframe);
+  }
+
+  if (keyframes.empty()) {
+    std::cerr << "'" << path << "' has no keyframes" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+int
+run_animation(AppFactoryBase&& app_factory,
+              const std::vector<CameraKeyframe>& keyframes,
+              const AnimationOptions& options)
+{
+  if (!check_options(options, keyframes))
+    return EXIT_FAILURE;
+
+  const CameraPath camera_path(keyframes);
+
+  // The small margin keeps a keyframe that falls exactly on a frame from being lost to rounding.
+  const int frame_count = int(std::floor((camera_path.get_duration() * options.frame_rate) + 1e-6)) + 1;
+
+  const int frame_thread_count = std::min(std::max(options.frame_thread_count, 1), frame_count);
+
+  const int hardware_thread_count = int(std::max(std::thread::hardware_concurrency(), 1u));
+
+  const int pixel_thread_count = (options.pixel_thread_count > 0)
+                                   ? options.pixel_thread_count
+                                   : std::max(hardware_thread_count / frame_thread_count, 1);
+
+  std::vector<std::unique_ptr<AppBase>> apps;
+
+  for (int i = 0; i < frame_thread_count; i++) {
+
+    std::unique_ptr<App> app(app_factory.create_app(nullptr));
+
+    if (!dynamic_cast<AppBase*>(app.get())) {
+      std::cerr << "Only apps derived from AppBase can be run without a window" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    apps.emplace_back(static_cast<AppBase*>(app.release()));
+
+    apps.back()->set_pixel_thread_count(pixel_thread_count);
+  }
+
+  using Clock = std::chrono::steady_clock;
+
+  using Seconds = std::chrono::duration<double>;
+
+  const auto start = Clock::now();
+
+  std::atomic<int> next_frame{ 0 };
+
+  std::atomic<bool> failed{ false };
+
+  // Guards the output, and the total time below.
+  std::mutex output_mutex;
+
+  double total_frame_time = 0;
+
+  auto render_frames = [&](AppBase& app) {
+    std::vector<unsigned char> rgba;
+
+    while (!failed) {
+
+      const int frame = next_frame++;
+
+      if (frame >= frame_count)
+        break;
+
+      const auto frame_start = Clock::now();
+
+      const double time = camera_path.get_start_time() + (frame / double(options.frame_rate));
+
+      app.set_camera_keyframe(camera_path.get_keyframe(time), frame);
+
+      for (int pass = 0; (options.max_pass_count <= 0) || (pass < options.max_pass_count); pass++) {
+        if (app.render_headless(options.width, options.height))
+          break;
+      }
+
+      int w = 0;
+      int h = 0;
+
+      const std::string path = format_output_path(options.output_pattern, frame);
+
+      if (!app.get_headless_image(rgba, w, h)) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        std::cerr << "No image was rendered for frame " << frame << std::endl;
+        failed = true;
+        break;
+      }
+
+      if (!stbi_write_png(path.c_str(), w, h, 4, rgba.data(), w * 4)) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        std::cerr << "Failed to write '" << path << "'" << std::endl;
+        failed = true;
+        break;
+      }
+
+      const double frame_time = Seconds(Clock::now() - frame_start).count();
+
+      std::lock_guard<std::mutex> lock(output_mutex);
+
+      total_frame_time += frame_time;
+
+      if (options.print_statistics)
+        std::cout << "Wrote '" << path << "' (" << (frame + 1) << " of " << frame_count << ") in "
+                  << (frame_time * 1000) << " ms" << std::endl;
+    }
+  };
+
+  std::vector<std::thread> threads;
+
+  for (std::size_t i = 1; i < apps.size(); i++)
+    threads.emplace_back(render_frames, std::ref(*apps[i]));
+
+  render_frames(*apps[0]);
+
+  for (auto& thread : threads)
+    thread.join();
+
+  for (auto& app : apps)
+    app->on_close();
+
+  apps.clear();
+
+  if (options.print_statistics && !failed) {
+
+    const double total_time = Seconds(Clock::now() - start).count();
+
+    std::cout << "Rendered " << frame_count << " frames of " << options.width << 'x' << options.height << " in "
+              << total_time << " s with " << frame_thread_count << " frame threads and " << pixel_thread_count
+              << " pixel threads each (" << ((total_frame_time * 1000) / frame_count) << " ms per frame, "
+              << (frame_count / total_time) << " frames per second)" << std::endl;
+  }
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+} // namespace window_blit
@@ -1,5 +1,7 @@
 #include <window_blit/app.hpp>
 
+#include <limits>
+
 namespace window_blit {
 
 App::App(GLFWwindow* window)
@@ -8,6 +10,39 @@ App::App(GLFWwindow* window)
 
 App::~App() = default;
 
+void
+App::on_window_resize(int w, int h)
+{
+  on_resize(w, h);
+}
+
+bool
+App::is_idle()
+{
+  return false;
+}
+
+double
+App::get_event_timeout()
+{
+  return is_idle() ? std::numeric_limits<double>::infinity() : 0.0;
+}
+
+bool
+App::is_presenting()
+{
+  return !m_window ||
+         (!glfwGetWindowAttrib(m_window, GLFW_ICONIFIED) && glfwGetWindowAttrib(m_window, GLFW_VISIBLE));
+}
+
+void
+App::on_iconify(bool /* iconified */)
+{}
+
+void
+App::on_focus(bool /* focused */)
+{}
+
 GLFWwindow*
 App::get_glfw_window() noexcept
 {
@@ -1,6 +1,22 @@
 #include <window_blit/app_base.hpp>
 
+#include <window_blit/animation.hpp>
+
+#include "dirty_region.hpp"
+#include "egl_context.hpp"
+#include "imgui_window.hpp"
+#include "input_queue.hpp"
+#include "input_recording.hpp"
+#include "pixel_pack.hpp"
+#include "pixel_transfer.hpp"
+#include "render_thread.hpp"
+#include "resolution_controller.hpp"
 #include "shader.hpp"
+#include "slice_controller.hpp"
+#include "triple_buffer.hpp"
+#include "upload_ring.hpp"
+#include "upload_thread.hpp"
+#include "upload_tuner.hpp"
 
 #include "stb_image_write.h"
 
@@ -14,10 +30,15 @@
 #include <imgui.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <vector>
 
@@ -25,6 +46,7 @@
 
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 
 #ifndef M_PI
 #define M_PI 3.1415f
@@ -34,81 +56,8 @@ namespace window_blit {
 
 namespace {
 
-const char* g_vert_shader = R"(
-#version 120
-
-attribute vec2 g_pos;
-
-varying vec2 g_tex_coord;
-
-void
-main()
-{
-  g_tex_coord = vec2((g_pos.x + 1) * 0.5, (1 - g_pos.y) * 0.5);
-
-  gl_Position = vec4(g_pos, 0.0, 1.0);
-}
-)";
-
-const char* g_frag_shader = R"(
-#version 120
-
-uniform sampler2D texture;
-
-varying vec2 g_tex_coord;
-
-uniform float g_sample_weight;
-
-uniform float g_tone_mapping;
-
-uniform float g_srgb;
-
-float hable_tone_map(float x)
-{
-  float A = 0.15;
-  float B = 0.50;
-  float C = 0.10;
-  float D = 0.20;
-  float E = 0.02;
-  float F = 0.30;
-
-  return ((x*(A*x+C*B)+D*E)/(x*(A*x+B)+D*F))-E/F;
-}
-
-vec3 apply_tone_map(vec3 color)
-{
-  float sig = max(color.r, max(color.g, color.b));
-  float luma = dot(color, vec3(0.2126, 0.7152, 0.0722));
-  float coeff = max(sig - 0.18, 1e-6) / max(sig, 1e-6);
-
-  coeff = pow(coeff, 20.0);
-
-  color = mix(color, vec3(luma), coeff);
-
-  sig = mix(sig, luma, coeff);
-
-  return color * vec3(hable_tone_map(sig) / sig);
-}
-
-vec3 to_srgb(vec3 color)
-{
-    bvec3 cutoff = lessThan(color, vec3(0.0031308));
-    vec3 higher = vec3(1.055)*pow(color, vec3(1.0/2.4)) - vec3(0.055);
-    vec3 lower = color * vec3(12.92);
-    return mix(higher, lower, vec3(cutoff.r, cutoff.g, cutoff.b));
-}
-
-void main()
-{
-  vec3 hdr_color = texture2D(texture, g_tex_coord).rgb * g_sample_weight;
-
-  vec3 ldr_color = mix(hdr_color, apply_tone_map(hdr_color), g_tone_mapping);
-
-  vec3 color = mix(ldr_color, to_srgb(ldr_color), g_srgb);
-
-  gl_FragColor = vec4(color, 1.0);
-}
-)";
+/// The most time that the camera moves by in one frame, in seconds.
+constexpr double g_max_camera_step = 0.25;
 
 class Camera
 {
@@ -124,11 +73,20 @@ public:
   virtual bool is_moving() const = 0;
 
   /// Performs translation based on move state.
-  virtual void move() = 0;
+  ///
+  /// @param seconds The time over which the camera moved.
+  virtual void move(float seconds) = 0;
 
   virtual glm::vec3 get_position() const = 0;
 
   virtual glm::mat3 get_rotation_transform() const = 0;
+
+  /// Places the camera, as done by the keyframes of an animation.
+  ///
+  /// @param yaw The rotation about the vertical axis, in radians.
+  ///
+  /// @param pitch The rotation about the horizontal axis, in radians.
+  virtual void set_pose(const glm::vec3& position, float yaw, float pitch) = 0;
 };
 
 class FirstPersonCamera : public Camera
@@ -136,7 +94,7 @@ class FirstPersonCamera : public Camera
 public:
   bool is_moving() const override { return m_up_speed || m_left_speed || m_down_speed || m_right_speed; }
 
-  void move() override
+  void move(float seconds) override
   {
     glm::vec3 delta(0, 0, 0);
 
@@ -147,7 +105,7 @@ public:
 
     auto world_delta = get_rotation_transform() * glm::normalize(delta);
 
-    m_position += world_delta * m_move_speed;
+    m_position += world_delta * (m_move_speed * seconds);
   }
 
   void handle_key(int key, int action) override
@@ -176,13 +134,21 @@ public:
 
   glm::vec3 get_position() const override { return m_position; }
 
+  void set_pose(const glm::vec3& position, float yaw, float pitch) override
+  {
+    m_position = position;
+    m_angle_x = pitch;
+    m_angle_y = yaw;
+  }
+
   glm::mat3 get_rotation_transform() const override
   {
     return glm::rotate(m_angle_y, glm::vec3(0, 1, 0)) * glm::rotate(m_angle_x, glm::vec3(1, 0, 0));
   }
 
 private:
-  float m_move_speed = 0.05;
+  /// In units per second.
+  float m_move_speed = 3;
 
   float m_up_speed = 0.0f;
 
@@ -199,6 +165,54 @@ private:
   glm::vec3 m_position = glm::vec3(0, 0, 0);
 };
 
+/// An image that was rendered on the render thread, to be uploaded by the
+/// window thread.
+struct RenderedFrame final
+{
+  enum class Layout
+  {
+    rgb_float,
+    rgba_float,
+    rgb_bytes
+  };
+
+  Layout layout = Layout::rgb_float;
+
+  int w = 0;
+
+  int h = 0;
+
+  float sample_weight = 1;
+
+  /// Whether the image was written by the last call to render.
+  bool written = false;
+
+  std::vector<unsigned char> data;
+
+  std::size_t get_pixel_size() const noexcept
+  {
+    switch (layout) {
+      case Layout::rgb_float:
+        break;
+      case Layout::rgba_float:
+        return sizeof(float) * 4;
+      case Layout::rgb_bytes:
+        return 3;
+    }
+
+    return sizeof(float) * 3;
+  }
+
+  /// Resizes the image, leaving the pixels undefined if the size or layout changed.
+  void resize(Layout new_layout, int new_w, int new_h)
+  {
+    layout = new_layout;
+    w = new_w;
+    h = new_h;
+    data.resize(std::size_t(w) * std::size_t(h) * get_pixel_size());
+  }
+};
+
 } // namespace
 
 class AppBaseImpl final
@@ -206,8 +220,15 @@ class AppBaseImpl final
   friend AppBase;
 
   AppBaseImpl(GLFWwindow* window)
-    : m_camera(new FirstPersonCamera())
+    // Without a context, there is nothing to create the buffers in.
+    : m_upload_ring((window || EglContext::is_any_current()) ? 3 : 0)
+    , m_camera(new FirstPersonCamera())
+    , m_headless(!window && !EglContext::is_any_current())
+    , m_windowless(!window)
   {
+    if (m_headless)
+      return;
+
     setup_shader_program();
 
     setup_buffers();
@@ -234,14 +255,13 @@ class AppBaseImpl final
     glEnableVertexAttribArray(m_pos_attr_location);
 
     glVertexAttribPointer(m_pos_attr_location, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, (void*)0);
-
-    int w = 0;
-    int h = 0;
-    glfwGetWindowSize(window, &w, &h);
   }
 
   ~AppBaseImpl()
   {
+    if (m_headless)
+      return;
+
     glDeleteBuffers(1, &m_vertex_buffer);
 
     glDeleteTextures(1, &m_texture);
@@ -251,284 +271,1793 @@ class AppBaseImpl final
 
   void on_frame(AppBase& app)
   {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    update_background_policy(app.get_glfw_window());
 
-    app.render_imgui();
+    const BackgroundPolicy policy = m_background_policy;
 
-    if (m_camera->is_moving()) {
+    // Matches the check made by the window loop, which only starts an ImGui frame for windows that present.
+    const bool presenting = app.is_presenting();
 
-      m_camera->move();
+    if (presenting) {
 
-      app.on_camera_change();
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+      // With several windows, ImGui is only drawn over one of them.
+      const GLFWwindow* imgui_window = get_imgui_window();
+
+      if (!imgui_window || (imgui_window == app.get_glfw_window()))
+        app.render_imgui();
     }
 
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    handle_input(app);
+
+    // The image that was accumulated in the background is presented by rendering once more.
+    if ((policy != BackgroundPolicy::accumulate) && m_finish_skipped.exchange(false))
+      invalidate();
 
     int w = 0;
     int h = 0;
-    glfwGetWindowSize(app.get_glfw_window(), &w, &h);
 
-    app.render(m_texture, w, h);
+    // A replay sets the size with on_window_resize instead, since the window may not have the recorded size.
+    if (!is_input_replayed())
+      glfwGetWindowSize(app.get_glfw_window(), &w, &h);
+
+    // Minimized windows may be reported as having no size, in which case the
+    // last size is kept, for background policies that keep rendering.
+    if ((w > 0) && (h > 0)) {
+      m_window_w = w;
+      m_window_h = h;
+    } else {
+      w = m_window_w;
+      h = m_window_h;
+    }
 
-    glUseProgram(m_program);
+    if (m_threaded_render) {
 
-    glUniform1f(m_sample_weight_uniform_location, m_sample_weight);
+      {
+        std::lock_guard<std::mutex> lock(m_render_mutex);
 
-    glUniform1f(m_tone_mapping_location, m_tone_mapping);
+        m_render_w = w;
+        m_render_h = h;
+      }
 
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-  }
+      // Started here rather than when requested, since the derived class may
+      // still have been under construction then.
+      if (!m_render_thread) {
 
-  void on_close() {}
+        std::unique_ptr<RenderThread> render_thread(
+          new RenderThread([this, &app] { return render_on_thread(app); }, m_render_priority));
 
-  bool frame_clicked() const noexcept { return m_frame_clicked; }
+        std::lock_guard<std::mutex> lock(m_render_thread_mutex);
 
-  void on_cursor_motion(double x, double y, AppBase& app)
-  {
-    if (!m_frame_clicked)
-      return;
+        m_render_thread = std::move(render_thread);
+      }
 
-    if (!m_frame_pos_initialized) {
+      if (policy != BackgroundPolicy::accumulate) {
+        if (RenderedFrame* frame = m_frames.acquire())
+          load_frame(*frame);
+      }
 
-      m_last_frame_pos = glm::vec2(x, y);
+    } else if ((w > 0) && (h > 0) && !is_converged() && is_frame_due(policy)) {
 
-      m_frame_pos_initialized = true;
-    }
+      glBindTexture(GL_TEXTURE_2D, m_texture);
 
-    float dx = x - m_last_frame_pos.x;
-    float dy = y - m_last_frame_pos.y;
+      render_frame(app, m_texture, w, h);
 
-    m_last_frame_pos.x = x;
-    m_last_frame_pos.y = y;
+      unmap_framebuffer();
 
-    app.on_cursor_motion(x, y, dx, dy);
-  }
+      flush_dirty_region();
+    }
 
-  void on_cursor_motion(double /* x */, double /* y */, double dx, double dy)
-  {
-    m_camera->handle_relative_motion(dx, dy);
+    if (presenting)
+      draw_texture();
   }
 
-  void on_cursor_button(int button, int action, int /* mods */)
+  /// Draws the latest image into the bound framebuffer, with the display transform.
+  void draw_texture()
   {
-#ifndef WINDOWBLIT_DISABLE_IMGUI
-    if (ImGui::GetIO().WantCaptureMouse)
-      return;
-#endif
-
-    if (button == GLFW_MOUSE_BUTTON_LEFT) {
+    // The texture may have been replaced while its storage was being allocated.
+    GLuint texture = m_texture;
 
-      m_frame_clicked = (action == GLFW_PRESS);
+    float texture_sample_weight = m_texture_sample_weight;
 
-      if (m_frame_clicked)
-        m_frame_pos_initialized = false;
-    }
-  }
+    bool display_encoded = m_texture_display_encoded;
 
-  void on_key(int key, int /* scancode */, int action, int /* mods */) { m_camera->handle_key(key, action); }
+    if (m_upload_thread) {
 
-  void on_resize(int /* w */, int /* h */) {}
+      float uploaded_sample_weight = 1;
 
-  glm::vec3 get_camera_position() const { return m_camera->get_position(); }
+      bool uploaded_display_encoded = false;
 
-  glm::mat3 get_camera_rotation_transform() const { return m_camera->get_rotation_transform(); }
+      const GLuint uploaded_texture = m_upload_thread->acquire(uploaded_sample_weight, uploaded_display_encoded);
 
-private:
-  bool setup_shader_program()
-  {
-    auto vert_shader = compile_shader(GL_VERTEX_SHADER, g_vert_shader, std::cerr);
+      if (m_present_uploaded && uploaded_texture) {
+        texture = uploaded_texture;
+        texture_sample_weight = uploaded_sample_weight;
+        display_encoded = uploaded_display_encoded;
+      }
+    }
 
-    if (!vert_shader)
-      return false;
+    glBindTexture(GL_TEXTURE_2D, texture);
 
-    auto frag_shader = compile_shader(GL_FRAGMENT_SHADER, g_frag_shader, std::cerr);
+    glUseProgram(m_program);
 
-    if (!frag_shader) {
-      glDeleteShader(vert_shader);
-      return false;
+    if (display_encoded) {
+      // The texels are already display colors, so the shader just passes them through.
+      glUniform1f(m_sample_weight_uniform_location, 1.0f);
+      glUniform1f(m_tone_mapping_location, 0.0f);
+      glUniform1f(m_srgb_location, 0.0f);
+    } else {
+      // While rendering on a thread, the sample weight belongs to the frame that was last uploaded.
+      const float sample_weight = m_render_thread ? m_frame_sample_weight : m_sample_weight;
+
+      glUniform1f(m_sample_weight_uniform_location, sample_weight / texture_sample_weight);
+      glUniform1f(m_tone_mapping_location, m_tone_mapping);
+      glUniform1f(m_srgb_location, m_srgb);
     }
 
-    m_program = link_shader_program(vert_shader, frag_shader, std::cerr);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  }
 
-    glDeleteShader(vert_shader);
+  void on_close(AppBase& app) { stop_render_thread(app); }
 
-    glDeleteShader(frag_shader);
+  void set_render_priority(float priority)
+  {
+    m_render_priority = priority;
 
-    return m_program != 0;
+    if (m_render_thread)
+      m_render_thread->set_weight(priority);
   }
 
-  void setup_buffers()
+  void set_threaded_render(bool enabled, AppBase& app)
   {
-    glGenBuffers(1, &m_vertex_buffer);
+    m_threaded_render = enabled;
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
+    if (!enabled)
+      stop_render_thread(app);
+  }
 
-    float vertices[8];
-    vertices[0] = -1; // top left
-    vertices[1] = 1;
-    vertices[2] = -1; // bottom left
-    vertices[3] = -1;
-    vertices[4] = 1; // top right
-    vertices[5] = 1;
-    vertices[6] = 1; // bottom right
-    vertices[7] = -1;
+  void stop_render_thread(AppBase& app)
+  {
+    if (!m_render_thread)
+      return;
 
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    std::unique_ptr<RenderThread> render_thread;
+
+    {
+      std::lock_guard<std::mutex> lock(m_render_thread_mutex);
+
+      render_thread = std::move(m_render_thread);
+    }
+
+    // Destroyed outside of the lock, since it waits for a call of render that may invalidate the image.
+    render_thread.reset();
+
+    // A camera change that was not delivered to the render thread is delivered here instead.
+    if (m_camera_change_pending.exchange(false))
+      app.on_camera_change();
   }
 
-  void setup_textures()
+  /// Called on the render thread, over and over.
+  ///
+  /// @return How long to wait before the next call, unless woken up earlier.
+  RenderThread::Clock::duration render_on_thread(AppBase& app)
   {
-    glActiveTexture(GL_TEXTURE0);
+    int w = 0;
+    int h = 0;
 
-    glGenTextures(1, &m_texture);
+    {
+      std::lock_guard<std::mutex> lock(m_render_mutex);
 
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+      w = m_render_w;
+      h = m_render_h;
+    }
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (m_camera_change_pending.exchange(false))
+      app.on_camera_change();
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Invalidations and policy changes wake the render thread up before the
+    // delays are over, so they only serve as a fallback.
+    const auto poll_delay = std::chrono::milliseconds(50);
 
-    // clang-format off
-    float initColorBuf[3 * 4] {
-      1, 0, 0,  0, 1, 0,
-      0, 0, 1,  1, 1, 1
-    };
-    // clang-format on
+    if ((w <= 0) || (h <= 0) || is_converged())
+      return poll_delay;
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 2, 0, GL_RGB, GL_FLOAT, initColorBuf);
-  }
+    const BackgroundPolicy policy = m_background_policy;
 
-  static std::string get_png_path()
-  {
-    for (int i = 0; i < 1024; i++) {
+    if (!is_frame_due(policy)) {
 
-      std::ostringstream stream;
+      if (policy != BackgroundPolicy::throttle)
+        return poll_delay;
 
-      stream << "snapshot-";
-      stream << std::setfill('0') << std::setw(4) << i;
-      stream << ".png";
+      const std::chrono::duration<double> throttle_delay(m_next_throttled_frame - glfwGetTime());
 
-      auto path = stream.str();
+      return std::chrono::duration_cast<RenderThread::Clock::duration>(throttle_delay);
+    }
 
-      if (!file_exists(path))
-        return path;
+    m_frames.back().written = false;
+
+    render_frame(app, 0, w, h);
+
+    unmap_framebuffer();
+
+    if (m_frames.back().written) {
+
+      m_frames.publish();
+
+      // Wakes the window thread, in case it is waiting for events, so that the frame gets displayed.
+      glfwPostEmptyEvent();
     }
 
-    return "";
+    return RenderThread::Clock::duration::zero();
   }
 
-  static bool file_exists(const std::string& path)
+  /// Calls @ref AppBase::render at the scaled resolution, and records whether
+  /// the image converged. Also calls @ref AppBase::on_resize beforehand, if
+  /// the resolution changed.
+  void render_frame(AppBase& app, GLuint texture_id, int window_w, int window_h)
   {
-    std::ifstream file(path.c_str());
+    // Captured first, so that an invalidation during rendering is not lost.
+    const unsigned int generation = m_generation;
 
-    return file.good();
-  }
+    // Without a window, frames are rendered at exactly the requested
+    // resolution, whether or not there is a context.
+    const bool dynamic_resolution = m_dynamic_resolution && !m_windowless;
 
-private:
-  GLuint m_vertex_buffer = 0;
+    if (!dynamic_resolution)
+      m_resolution_controller.reset();
 
-  GLuint m_texture = 0;
+    float scale = dynamic_resolution ? m_resolution_controller.get_scale() : m_fixed_resolution_scale.load();
 
-  GLuint m_program = 0;
+    if (m_windowless)
+      scale = 1;
 
-  GLint m_pos_attr_location = -1;
+    const int w = std::max(int(std::lround(window_w * scale)), 1);
+    const int h = std::max(int(std::lround(window_h * scale)), 1);
 
-  GLint m_sample_weight_uniform_location = -1;
+    m_resolution_scale = scale;
 
-  float m_sample_weight = 1;
+    const bool resized = (w != m_render_size_w) || (h != m_render_size_h);
 
-  GLint m_tone_mapping_location = -1;
+    if (resized) {
 
-  float m_tone_mapping = 1.0f;
+      const bool own_texture = (texture_id == m_texture);
 
-  GLint m_srgb_location = -1;
+      // A unit of progressive work is a sample of every pixel, so it costs as much more as there are more pixels.
+      if ((m_render_size_w > 0) && (m_render_size_h > 0))
+        m_slice_controller.scale_unit_cost((double(w) * h) / (double(m_render_size_w) * m_render_size_h));
 
-  float m_srgb = 1;
+      m_render_size_w = w;
+      m_render_size_h = h;
+      app.on_resize(w, h);
 
-  std::unique_ptr<Camera> m_camera;
+      // Immutable storage is resized by replacing the texture, so the storage
+      // is allocated before the frame is handed the texture, even if the app
+      // does not call the base on_resize. The uploads of the frame, including
+      // its bands, then all go to the new texture.
+      if (own_texture) {
+        on_resize(w, h);
+        texture_id = m_texture;
+      }
+    }
 
-  bool m_frame_clicked = false;
+    m_converge_requested = false;
 
-  bool m_frame_pos_initialized = false;
+    m_frame_sliced = false;
 
-  glm::vec2 m_last_frame_pos = glm::vec2(0, 0);
-};
+    const auto frame_start = std::chrono::steady_clock::now();
 
-AppBase::AppBase(GLFWwindow* window)
-  : App(window)
-  , m_impl(new AppBaseImpl(window))
-{}
+    app.render(texture_id, w, h);
 
-AppBase::~AppBase()
-{
-  delete m_impl;
-}
+    const std::chrono::duration<double> frame_time = std::chrono::steady_clock::now() - frame_start;
 
-void
-AppBase::on_frame()
-{
-  m_impl->on_frame(*this);
-}
+    if (m_converge_requested)
+      m_converged_generation = generation;
 
-void
-AppBase::on_key(int key, int scancode, int action, int mods)
-{
-  m_impl->on_key(key, scancode, action, mods);
-}
+    // Progressive frames always take up the whole frame budget, so the time of
+    // a unit of work is what is held to the target instead. The frame of a
+    // resize also pays for the reallocation in on_resize, so it is not measured.
+    if (dynamic_resolution && !resized)
+      m_resolution_controller.add_measurement(m_frame_sliced ? m_slice_controller.get_unit_cost() : frame_time.count(),
+                                              m_target_frame_time);
+  }
 
-void
-AppBase::on_resize(int w, int h)
-{
-  return m_impl->on_resize(w, h);
-}
+  /// Renders a frame without a window. Without a context, the frame is stored
+  /// in @ref m_frames, otherwise it is drawn into the bound framebuffer.
+  ///
+  /// @return Whether the image has converged.
+  bool render_headless(AppBase& app, int w, int h)
+  {
+    // Without a replay there is no input, and no GLFW clock to move the camera by.
+    if (is_input_replayed())
+      handle_input(app);
 
-void
-AppBase::on_close()
-{}
+    if (m_headless) {
 
-void
-AppBase::on_camera_change()
-{}
+      render_frame(app, 0, w, h);
 
-glm::vec3
-AppBase::get_camera_position() const
-{
-  return m_impl->get_camera_position();
-}
+      unmap_framebuffer();
 
-glm::mat3
-AppBase::get_camera_rotation_transform() const
-{
-  return m_impl->get_camera_rotation_transform();
-}
+      return is_converged();
+    }
 
-void
-AppBase::on_cursor_motion(double x, double y)
-{
-  if (!m_impl->frame_clicked())
-    return;
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-  int xMax = 0;
-  int yMax = 0;
-  glfwGetWindowSize(get_glfw_window(), &xMax, &yMax);
+    if (!is_converged()) {
 
-  m_impl->on_cursor_motion(x / xMax, y / yMax, *this);
+      glBindTexture(GL_TEXTURE_2D, m_texture);
 
-  on_camera_change();
-}
+      render_frame(app, m_texture, w, h);
 
-void
-AppBase::on_cursor_button(int button, int action, int mods)
-{
-  m_impl->on_cursor_button(button, action, mods);
-}
+      unmap_framebuffer();
 
-void
-AppBase::on_cursor_motion(double x, double y, double dx, double dy)
-{
-  m_impl->on_cursor_motion(x, y, dx, dy);
+      flush_dirty_region();
+    }
+
+    draw_texture();
+
+    return is_converged();
+  }
+
+  /// Applies the display transform to the last frame stored without a
+  /// context, the way the fragment shader would.
+  bool get_headless_image(std::vector<unsigned char>& rgba, int& w, int& h)
+  {
+    const RenderedFrame& frame = m_frames.back();
+
+    if (!m_headless || (frame.w <= 0) || (frame.h <= 0))
+      return false;
+
+    w = frame.w;
+    h = frame.h;
+
+    const std::size_t pixel_count = std::size_t(w) * std::size_t(h);
+
+    rgba.resize(pixel_count * 4);
+
+    DisplayTransform display;
+    display.sample_weight = frame.sample_weight;
+    display.tone_mapping = m_tone_mapping;
+    display.srgb = m_srgb;
+
+    const float* pixels = reinterpret_cast<const float*>(frame.data.data());
+
+    std::vector<float> normalized;
+
+    if (frame.layout == RenderedFrame::Layout::rgb_bytes) {
+      // Byte textures are normalized by the GPU, and then transformed like any other.
+      normalized.resize(frame.data.size());
+      std::transform(frame.data.begin(), frame.data.end(), normalized.begin(), [](unsigned char value) {
+        return value * (1.0f / 255.0f);
+      });
+      pixels = normalized.data();
+    }
+
+    const int channel_count = (frame.layout == RenderedFrame::Layout::rgba_float) ? 4 : 3;
+
+    encode_display_rgba8(pixels, rgba.data(), pixel_count, display, channel_count);
+
+    return true;
+  }
+
+  void set_converged() noexcept { m_converge_requested = true; }
+
+  void invalidate()
+  {
+    m_generation++;
+
+    // This may be called from any thread, while the window thread stops the render thread.
+    std::lock_guard<std::mutex> lock(m_render_thread_mutex);
+
+    if (m_render_thread)
+      m_render_thread->wake();
+  }
+
+  bool is_converged() const noexcept { return m_converged_generation == m_generation; }
+
+  bool is_idle() const { return is_converged() && !m_camera->is_moving(); }
+
+  /// Gets the background policy that applies to the current state of the window.
+  BackgroundPolicy get_window_policy(GLFWwindow* window) const
+  {
+    if (!window)
+      return BackgroundPolicy::keep_running;
+
+    const bool minimized =
+      glfwGetWindowAttrib(window, GLFW_ICONIFIED) || !glfwGetWindowAttrib(window, GLFW_VISIBLE);
+
+    const bool focused = glfwGetWindowAttrib(window, GLFW_FOCUSED);
+
+    return minimized ? m_minimized_policy : (focused ? BackgroundPolicy::keep_running : m_unfocused_policy);
+  }
+
+  /// Called on the window thread, whenever the window may have been minimized,
+  /// restored, hidden, shown, focused or unfocused.
+  void update_background_policy(GLFWwindow* window)
+  {
+    if (!window)
+      return;
+
+    const BackgroundPolicy policy = get_window_policy(window);
+
+    if (policy == m_background_policy)
+      return;
+
+    m_background_policy = policy;
+
+    if (m_render_thread)
+      m_render_thread->wake();
+  }
+
+  /// Indicates whether a frame should be rendered now, given the background
+  /// policy. Called on the thread that renders.
+  bool is_frame_due(BackgroundPolicy policy)
+  {
+    switch (policy) {
+      case BackgroundPolicy::keep_running:
+      case BackgroundPolicy::accumulate:
+        return true;
+      case BackgroundPolicy::pause:
+        return false;
+      case BackgroundPolicy::throttle:
+        break;
+    }
+
+    const double now = glfwGetTime();
+
+    if (now < m_next_throttled_frame)
+      return false;
+
+    m_next_throttled_frame = now + (1.0 / std::max(m_throttled_frame_rate.load(), 0.001f));
+
+    return true;
+  }
+
+  /// Gets how long the window may wait for events before drawing the next frame.
+  double get_event_timeout() const
+  {
+    const double forever = std::numeric_limits<double>::infinity();
+
+    const BackgroundPolicy policy = m_background_policy;
+
+    if ((policy == BackgroundPolicy::pause) || is_idle())
+      return forever;
+
+    // The render thread wakes the window thread up whenever there is a frame to present.
+    if (m_render_thread && (policy != BackgroundPolicy::keep_running))
+      return forever;
+
+    if (policy == BackgroundPolicy::throttle)
+      return std::max(m_next_throttled_frame - glfwGetTime(), 0.0);
+
+    return 0;
+  }
+
+  /// Calls @ref AppBase::render_slice until the frame budget is spent.
+  void render_slices(AppBase& app, GLuint texture_id, int w, int h)
+  {
+    using Clock = std::chrono::steady_clock;
+
+    using Seconds = std::chrono::duration<double>;
+
+    const auto frame_start = Clock::now();
+
+    m_frame_sliced = true;
+
+    for (bool first_slice = true;; first_slice = false) {
+
+      const double elapsed = Seconds(Clock::now() - frame_start).count();
+
+      const int work = m_slice_controller.get_slice_size(m_frame_budget - elapsed, first_slice);
+
+      if (work <= 0)
+        break;
+
+      const auto slice_start = Clock::now();
+
+      const bool more_work = app.render_slice(w, h, work);
+
+      m_slice_controller.add_measurement(work, Seconds(Clock::now() - slice_start).count());
+
+      if (!more_work) {
+        set_converged();
+        break;
+      }
+    }
+
+    if (m_background_policy == BackgroundPolicy::accumulate) {
+      // Presented once the window is back in the foreground.
+      m_finish_skipped = true;
+      return;
+    }
+
+    app.finish_frame(texture_id, w, h);
+  }
+
+  void set_frame_budget(float seconds) { m_frame_budget = std::max(seconds, 0.0f); }
+
+  /// Calls @ref AppBase::on_camera_change, on the render thread if there is one.
+  void notify_camera_change(AppBase& app)
+  {
+    invalidate();
+
+    if (m_render_thread)
+      m_camera_change_pending = true;
+    else
+      app.on_camera_change();
+  }
+
+  /// Indicates whether the load and map functions copy the image into @ref
+  /// m_frames instead of uploading it, which is the case without a context.
+  bool stores_frames() const noexcept { return m_headless || RenderThread::is_render_thread(); }
+
+  /// Copies an image into the frame being rendered on the render thread.
+  void store_frame(RenderedFrame::Layout layout, const void* pixels, int w, int h)
+  {
+    RenderedFrame& frame = m_frames.back();
+
+    frame.resize(layout, std::max(w, 0), std::max(h, 0));
+
+    std::memcpy(frame.data.data(), pixels, frame.data.size());
+
+    frame.sample_weight = m_sample_weight;
+
+    frame.written = true;
+  }
+
+  void store_frame_rows(RenderedFrame::Layout layout, const void* pixels, int w, int h, int y, int row_count)
+  {
+    RenderedFrame& frame = m_frames.back();
+
+    if ((frame.layout != layout) || (frame.w != w) || (frame.h != h))
+      frame.resize(layout, w, h);
+
+    const std::size_t row_size = std::size_t(w) * frame.get_pixel_size();
+
+    // The rows are already clipped to the image.
+    std::memcpy(frame.data.data() + (std::size_t(y) * row_size),
+                static_cast<const unsigned char*>(pixels) + (std::size_t(y) * row_size),
+                std::size_t(row_count) * row_size);
+
+    frame.sample_weight = m_sample_weight;
+
+    frame.written = true;
+  }
+
+  /// Maps the frame being rendered, on the render thread.
+  MappedFramebuffer map_frame(int w, int h)
+  {
+    MappedFramebuffer mapped;
+
+    if ((w <= 0) || (h <= 0))
+      return mapped;
+
+    RenderedFrame& frame = m_frames.back();
+
+    frame.resize(RenderedFrame::Layout::rgb_float, w, h);
+
+    mapped.rgb = reinterpret_cast<float*>(frame.data.data());
+    mapped.width = w;
+    mapped.height = h;
+    mapped.pitch = std::size_t(w) * frame.get_pixel_size();
+
+    m_frame_mapped = true;
+
+    return mapped;
+  }
+
+  void unmap_frame()
+  {
+    if (!m_frame_mapped)
+      return;
+
+    m_frame_mapped = false;
+
+    m_frames.back().sample_weight = m_sample_weight;
+
+    m_frames.back().written = true;
+  }
+
+  /// Uploads a frame from the render thread, on the window thread.
+  ///
+  /// @details The upload thread is handed the pixels of the frame instead of a
+  /// copy of them. The frame gets one of its spare buffers in return, which the
+  /// render thread overwrites before publishing the frame again.
+  void load_frame(RenderedFrame& frame)
+  {
+    m_frame_sample_weight = frame.sample_weight;
+
+    DisplayTransform display;
+    display.sample_weight = frame.sample_weight;
+    display.tone_mapping = m_tone_mapping;
+    display.srgb = m_srgb;
+
+    const UploadFormat format = get_float_format();
+
+    const auto* floats = reinterpret_cast<const float*>(frame.data.data());
+
+    if (m_upload_thread) {
+
+      std::vector<unsigned char> data = m_upload_thread->take_buffer();
+
+      // Keeps the size of the frame consistent with its data, since row bands are written without resizing it.
+      data.resize(frame.data.size());
+
+      std::swap(data, frame.data);
+
+      switch (frame.layout) {
+        case RenderedFrame::Layout::rgb_float:
+          m_upload_thread->submit(std::move(data), frame.w, frame.h, format, display);
+          break;
+        case RenderedFrame::Layout::rgba_float:
+          m_upload_thread->submit_rgba(std::move(data), frame.w, frame.h, format, display);
+          break;
+        case RenderedFrame::Layout::rgb_bytes:
+          m_upload_thread->submit(std::move(data), frame.w, frame.h, get_byte_layout());
+          break;
+      }
+
+      m_present_uploaded = true;
+
+      return;
+    }
+
+    switch (frame.layout) {
+      case RenderedFrame::Layout::rgb_float:
+        load_texture(m_texture, frame.w, frame.h, make_rgb_transfer(floats, frame.w, frame.h, format, display));
+        break;
+      case RenderedFrame::Layout::rgba_float:
+        load_texture(m_texture, frame.w, frame.h, make_rgba_transfer(floats, frame.w, frame.h, format, display));
+        break;
+      case RenderedFrame::Layout::rgb_bytes:
+        load_texture(
+          m_texture, frame.w, frame.h, make_rgb_transfer(frame.data.data(), frame.w, frame.h, get_byte_layout()));
+        break;
+    }
+  }
+
+  bool frame_clicked() const noexcept { return m_frame_clicked; }
+
+  /// Handles the input events of the frame, with all of the cursor motion merged into one camera update.
+  void handle_input(AppBase& app)
+  {
+    m_input_queue.drain(m_input_events);
+
+    bool camera_changed = false;
+
+    bool cursor_moved = false;
+
+    InputEvent motion;
+
+    {
+      std::lock_guard<std::mutex> lock(m_camera_mutex);
+
+      for (const InputEvent& event : m_input_events) {
+        switch (event.type) {
+          case InputEvent::Type::key:
+            // The camera moves with the keys that were held until this event, and from then on with the new ones.
+            camera_changed |= move_camera(event.time);
+            m_camera->handle_key(event.key, event.action);
+            break;
+          case InputEvent::Type::cursor_motion:
+            motion.x = event.x;
+            motion.y = event.y;
+            motion.dx += event.dx;
+            motion.dy += event.dy;
+            cursor_moved = true;
+            break;
+        }
+      }
+
+      camera_changed |= move_camera(get_input_time());
+    }
+
+    if (cursor_moved) {
+      app.on_cursor_motion(motion.x, motion.y, motion.dx, motion.dy);
+      camera_changed = true;
+    }
+
+    if (camera_changed)
+      notify_camera_change(app);
+  }
+
+  /// Moves the camera by the time that passed since it last moved. The camera must be locked.
+  ///
+  /// @return Whether the camera moved.
+  bool move_camera(double time)
+  {
+    // Long stalls, such as at a breakpoint, are not made up for all at once.
+    const double seconds = std::min(std::max(time - m_camera_time, 0.0), g_max_camera_step);
+
+    m_camera_time = std::max(time, m_camera_time);
+
+    if (!m_camera->is_moving() || (seconds <= 0))
+      return false;
+
+    m_camera->move(float(seconds));
+
+    return true;
+  }
+
+  void on_key(int key, int action)
+  {
+    InputEvent event;
+    event.type = InputEvent::Type::key;
+    event.time = get_input_time();
+    event.key = key;
+    event.action = action;
+
+    m_input_queue.push(event);
+  }
+
+  void on_cursor_motion(double x, double y)
+  {
+    if (!m_frame_clicked)
+      return;
+
+    if (!m_frame_pos_initialized) {
+
+      m_last_frame_pos = glm::vec2(x, y);
+
+      m_frame_pos_initialized = true;
+    }
+
+    float dx = x - m_last_frame_pos.x;
+    float dy = y - m_last_frame_pos.y;
+
+    m_last_frame_pos.x = x;
+    m_last_frame_pos.y = y;
+
+    InputEvent event;
+    event.type = InputEvent::Type::cursor_motion;
+    event.time = get_input_time();
+    event.x = x;
+    event.y = y;
+    event.dx = dx;
+    event.dy = dy;
+
+    m_input_queue.push(event);
+  }
+
+  void on_cursor_motion(double /* x */, double /* y */, double dx, double dy)
+  {
+    std::lock_guard<std::mutex> lock(m_camera_mutex);
+
+    m_camera->handle_relative_motion(dx, dy);
+  }
+
+  void on_cursor_button(int button, int action, int /* mods */)
+  {
+#ifndef WINDOWBLIT_DISABLE_IMGUI
+    // There is no ImGui context without a window.
+    if (ImGui::GetCurrentContext() && ImGui::GetIO().WantCaptureMouse)
+      return;
+#endif
+
+    if (button == GLFW_MOUSE_BUTTON_LEFT) {
+
+      m_frame_clicked = (action == GLFW_PRESS);
+
+      if (m_frame_clicked)
+        m_frame_pos_initialized = false;
+    }
+  }
+
+  void on_resize(int w, int h)
+  {
+    // Stored frames are uploaded by the window thread, if there is one.
+    if (stores_frames())
+      return;
+
+    // The storage is allocated here so that, while the size stays the same,
+    // frame uploads only have to update the existing texture.
+    if ((w > 0) && (h > 0) && (m_texture_format != GL_NONE))
+      allocate_texture_storage(w, h, m_texture_format);
+  }
+
+  glm::vec3 get_camera_position() const
+  {
+    std::lock_guard<std::mutex> lock(m_camera_mutex);
+
+    return m_camera->get_position();
+  }
+
+  glm::mat3 get_camera_rotation_transform() const
+  {
+    std::lock_guard<std::mutex> lock(m_camera_mutex);
+
+    return m_camera->get_rotation_transform();
+  }
+
+  void set_camera_keyframe(AppBase& app, const CameraKeyframe& keyframe, int frame)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_camera_mutex);
+
+      m_camera->set_pose(keyframe.position, glm::radians(keyframe.yaw), glm::radians(keyframe.pitch));
+    }
+
+    notify_camera_change(app);
+
+    app.on_frame_seed(unsigned(frame));
+  }
+
+  /// Gets the size of the window, or without one or during a replay, the size
+  /// last passed to @ref AppBase::on_window_resize.
+  void get_window_size(AppBase& app, int& w, int& h) const
+  {
+    if (app.get_glfw_window() && !is_input_replayed()) {
+      glfwGetWindowSize(app.get_glfw_window(), &w, &h);
+    } else {
+      w = m_window_w;
+      h = m_window_h;
+    }
+  }
+
+  void on_window_resize(int w, int h)
+  {
+    if ((w > 0) && (h > 0)) {
+      m_window_w = w;
+      m_window_h = h;
+    }
+
+    // The new size is passed to on_resize just before the next frame is rendered, after scaling it.
+    invalidate();
+  }
+
+
+  void load_rgb_region(GLuint texture_id, const void* pixels, bool bytes, int w, int h, const DirtyRegion::Rect& rect)
+  {
+    if (stores_frames()) {
+      // The frames are double buffered, so the rest of the image has to be copied too.
+      store_frame(bytes ? RenderedFrame::Layout::rgb_bytes : RenderedFrame::Layout::rgb_float, pixels, w, h);
+      return;
+    }
+
+    if (texture_id != m_texture) {
+      // Without knowing the storage of the texture, the best we can do is upload right away.
+      DirtyRegion clipped;
+      clipped.add(rect.x_min, rect.y_min, rect.width(), rect.height(), w, h);
+      const UploadFormat format = get_float_format();
+      glBindTexture(GL_TEXTURE_2D, texture_id);
+      for (const auto& r : clipped.rects())
+        upload_rect(pixels, bytes, format, w, r);
+      return;
+    }
+
+    if ((pixels != m_region_pixels) || (bytes != m_region_bytes) || (w != m_region_w) || (h != m_region_h))
+      flush_dirty_region();
+
+    m_region_pixels = pixels;
+    m_region_bytes = bytes;
+    m_region_w = w;
+    m_region_h = h;
+
+    m_dirty_region.add(rect.x_min, rect.y_min, rect.width(), rect.height(), w, h);
+  }
+
+  void flush_dirty_region()
+  {
+    if (m_dirty_region.empty())
+      return;
+
+    const void* pixels = m_region_pixels;
+
+    // Cleared first, since the upload functions flush the region too.
+    m_region_pixels = nullptr;
+
+    const UploadFormat format = get_float_format();
+
+    const GLenum internal_format =
+      m_region_bytes ? get_internal_format(get_byte_layout()) : get_internal_format(format);
+
+    // 8-bit images and display encoded images can share an internal format.
+    const bool display_encoded = !m_region_bytes && (format == UploadFormat::display_rgba8);
+
+    if ((m_region_w != m_texture_w) || (m_region_h != m_texture_h) || (internal_format != m_texture_format) ||
+        (display_encoded != m_texture_display_encoded)) {
+
+      // The rest of the texture is undefined after allocating storage for it.
+      m_dirty_region.clear();
+
+      if (m_region_bytes)
+        load_rgb(m_texture, static_cast<const unsigned char*>(pixels), m_region_w, m_region_h);
+      else
+        load_rgb(m_texture, static_cast<const float*>(pixels), m_region_w, m_region_h);
+
+      return;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+
+    for (const auto& rect : m_dirty_region.rects())
+      upload_rect(pixels, m_region_bytes, format, m_region_w, rect);
+
+    m_dirty_region.clear();
+
+    m_present_uploaded = false;
+  }
+
+  MappedFramebuffer map_framebuffer(int w, int h)
+  {
+    if (stores_frames())
+      return map_frame(w, h);
+
+    m_upload_ring.cancel_upload();
+
+    m_mapped_framebuffer = MappedFramebuffer();
+
+    if ((w <= 0) || (h <= 0))
+      return m_mapped_framebuffer;
+
+    const std::size_t pitch = std::size_t(w) * sizeof(float) * 3;
+
+    void* pixels = m_upload_ring.begin_upload(pitch * std::size_t(h));
+
+    if (!pixels)
+      return m_mapped_framebuffer;
+
+    m_mapped_framebuffer.rgb = static_cast<float*>(pixels);
+    m_mapped_framebuffer.width = w;
+    m_mapped_framebuffer.height = h;
+    m_mapped_framebuffer.pitch = pitch;
+
+    return m_mapped_framebuffer;
+  }
+
+  void unmap_framebuffer()
+  {
+    if (stores_frames()) {
+      unmap_frame();
+      return;
+    }
+
+    if (!m_mapped_framebuffer.rgb)
+      return;
+
+    const int w = m_mapped_framebuffer.width;
+    const int h = m_mapped_framebuffer.height;
+
+    m_mapped_framebuffer = MappedFramebuffer();
+
+    // Any pending rectangles are older than this image.
+    m_dirty_region.clear();
+
+    m_region_pixels = nullptr;
+
+    allocate_texture_storage(w, h, GL_RGB32F);
+
+    m_upload_ring.end_upload(0, 0, w, h, GL_RGB, GL_FLOAT);
+
+    m_texture_sample_weight = 1;
+
+    m_texture_display_encoded = false;
+
+    m_present_uploaded = false;
+  }
+
+  void load_rgb(GLuint texture_id, const float* rgb, int w, int h)
+  {
+    if (stores_frames()) {
+      store_frame(RenderedFrame::Layout::rgb_float, rgb, w, h);
+      return;
+    }
+
+    if (m_upload_thread && (texture_id == m_texture)) {
+      m_upload_thread->submit(rgb, w, h, get_float_format(), get_display_transform());
+      m_present_uploaded = true;
+      return;
+    }
+
+    load_texture(texture_id, w, h, make_rgb_transfer(rgb, w, h, get_float_format(), get_display_transform()));
+  }
+
+  void load_rgb(GLuint texture_id, const unsigned char* rgb, int w, int h)
+  {
+    if (stores_frames()) {
+      store_frame(RenderedFrame::Layout::rgb_bytes, rgb, w, h);
+      return;
+    }
+
+    if (m_upload_thread && (texture_id == m_texture)) {
+      m_upload_thread->submit(rgb, w, h, get_byte_layout());
+      m_present_uploaded = true;
+      return;
+    }
+
+    load_texture(texture_id, w, h, make_rgb_transfer(rgb, w, h, get_byte_layout()));
+  }
+
+  void load_rgba(GLuint texture_id, const float* rgba, int w, int h)
+  {
+    if (stores_frames()) {
+      store_frame(RenderedFrame::Layout::rgba_float, rgba, w, h);
+      return;
+    }
+
+    if (m_upload_thread && (texture_id == m_texture)) {
+      m_upload_thread->submit_rgba(rgba, w, h, get_float_format(), get_display_transform());
+      m_present_uploaded = true;
+      return;
+    }
+
+    load_texture(texture_id, w, h, make_rgba_transfer(rgba, w, h, get_float_format(), get_display_transform()));
+  }
+
+  void load_rgb_rows(GLuint texture_id, const float* rgb, int w, int h, int y, int row_count)
+  {
+    if (!clip_rows(h, y, row_count))
+      return;
+
+    if (stores_frames()) {
+      store_frame_rows(RenderedFrame::Layout::rgb_float, rgb, w, h, y, row_count);
+      return;
+    }
+
+    const float* band = rgb + (std::size_t(y) * std::size_t(w) * 3);
+
+    load_rows(
+      texture_id, w, h, y, row_count, make_rgb_transfer(band, w, row_count, get_float_format(), get_display_transform()));
+  }
+
+  void load_rgb_rows(GLuint texture_id, const unsigned char* rgb, int w, int h, int y, int row_count)
+  {
+    if (!clip_rows(h, y, row_count))
+      return;
+
+    if (stores_frames()) {
+      store_frame_rows(RenderedFrame::Layout::rgb_bytes, rgb, w, h, y, row_count);
+      return;
+    }
+
+    const unsigned char* band = rgb + (std::size_t(y) * std::size_t(w) * 3);
+
+    load_rows(texture_id, w, h, y, row_count, make_rgb_transfer(band, w, row_count, get_byte_layout()));
+  }
+
+  void set_async_upload(bool enabled, GLFWwindow* window)
+  {
+    // The upload thread shares the context of the window.
+    if (!window)
+      return;
+
+    if (!enabled)
+      m_upload_thread.reset();
+    else if (!m_upload_thread)
+      m_upload_thread = UploadThread::create(window);
+
+    // Creating the shared context may have changed the current one.
+    glfwMakeContextCurrent(window);
+
+    m_present_uploaded = false;
+  }
+
+  /// Uploads a rectangle of an image to the bound texture, which must already
+  /// have storage for it.
+  ///
+  /// @param format The format of the texture, if the image is floating point.
+  ///
+  /// @param w The width of the whole image.
+  void upload_rect(const void* pixels, bool bytes, UploadFormat format, int w, const DirtyRegion::Rect& rect)
+  {
+    // The padded formats are filled from unpadded rows just the same, by the driver.
+    if (bytes || (format == UploadFormat::rgb32f) || (format == UploadFormat::rgba32f)) {
+
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, w);
+      glPixelStorei(GL_UNPACK_SKIP_PIXELS, rect.x_min);
+      glPixelStorei(GL_UNPACK_SKIP_ROWS, rect.y_min);
+
+      glTexSubImage2D(GL_TEXTURE_2D,
+                      0,
+                      rect.x_min,
+                      rect.y_min,
+                      rect.width(),
+                      rect.height(),
+                      GL_RGB,
+                      bytes ? GL_UNSIGNED_BYTE : GL_FLOAT,
+                      pixels);
+
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+      glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+      glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+      return;
+    }
+
+    // The packed formats need a conversion anyway, so the rows are packed
+    // tightly into a staging buffer. The weight already in the texture is used,
+    // so that the rest of the texture stays consistent with the new texels.
+    const float* rgb = static_cast<const float*>(pixels);
+    const float scale = m_texture_sample_weight;
+    const std::size_t row_pixels = std::size_t(rect.width());
+    const std::size_t row_count = std::size_t(rect.height());
+
+    auto row_begin = [rgb, w, rect](std::size_t row) {
+      return rgb + (((rect.y_min + row) * std::size_t(w)) + rect.x_min) * 3;
+    };
+
+    if ((format == UploadFormat::rgb16f) || (format == UploadFormat::rgba16f)) {
+      m_upload_ring.upload(row_pixels * row_count * 6,
+                           rect.x_min,
+                           rect.y_min,
+                           rect.width(),
+                           rect.height(),
+                           GL_RGB,
+                           GL_HALF_FLOAT,
+                           [row_begin, row_pixels, row_count, scale](void* dst) {
+                             auto* out = static_cast<std::uint16_t*>(dst);
+                             for (std::size_t row = 0; row < row_count; row++)
+                               pack_half(row_begin(row), out + (row * row_pixels * 3), row_pixels * 3, scale);
+                           });
+    } else if (format == UploadFormat::display_rgba8) {
+
+      DisplayTransform display = get_display_transform();
+
+      display.sample_weight = scale;
+
+      m_upload_ring.upload(row_pixels * row_count * 4,
+                           rect.x_min,
+                           rect.y_min,
+                           rect.width(),
+                           rect.height(),
+                           GL_RGBA,
+                           GL_UNSIGNED_BYTE,
+                           [row_begin, row_pixels, row_count, display](void* dst) {
+                             auto* out = static_cast<std::uint8_t*>(dst);
+                             for (std::size_t row = 0; row < row_count; row++)
+                               encode_display_rgba8(row_begin(row), out + (row * row_pixels * 4), row_pixels, display);
+                           });
+    } else {
+      m_upload_ring.upload(row_pixels * row_count * 4,
+                           rect.x_min,
+                           rect.y_min,
+                           rect.width(),
+                           rect.height(),
+                           GL_RGB,
+                           GL_UNSIGNED_INT_5_9_9_9_REV,
+                           [row_begin, row_pixels, row_count, scale](void* dst) {
+                             auto* out = static_cast<std::uint32_t*>(dst);
+                             for (std::size_t row = 0; row < row_count; row++)
+                               pack_rgb9_e5(row_begin(row), out + (row * row_pixels), row_pixels, scale);
+                           });
+    }
+  }
+
+  /// Clips a band of rows to the height of the image.
+  ///
+  /// @return False if none of the rows are in the image.
+  static bool clip_rows(int h, int& y, int& row_count) noexcept
+  {
+    const int y_end = std::min(y + row_count, h);
+
+    y = std::max(y, 0);
+
+    row_count = y_end - y;
+
+    return row_count > 0;
+  }
+
+  /// Uploads a band of rows, with @p transfer describing just the band.
+  void load_rows(GLuint texture_id, int w, int h, int y, int row_count, const PixelTransfer& transfer)
+  {
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+
+    if (texture_id != m_texture) {
+      // The caller is responsible for the storage of their own textures.
+      std::vector<unsigned char> pixels(transfer.size);
+      transfer.fill(pixels.data());
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, w, row_count, transfer.format, transfer.type, pixels.data());
+      return;
+    }
+
+    if (w <= 0)
+      return;
+
+    // Pending rectangles are older than the band, and would overwrite it when flushed.
+    m_dirty_region.clear();
+
+    m_region_pixels = nullptr;
+
+    // The storage is only allocated for the first band, the rest of the
+    // texture will be filled by the bands that follow.
+    allocate_texture_storage(w, h, transfer.internal_format);
+
+    m_upload_ring.upload(transfer.size, 0, y, w, row_count, transfer.format, transfer.type, transfer.fill);
+
+    m_texture_sample_weight = transfer.sample_weight;
+
+    m_texture_display_encoded = transfer.display_encoded;
+
+    m_present_uploaded = false;
+  }
+
+  void load_texture(GLuint texture_id, int w, int h, const PixelTransfer& transfer)
+  {
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+
+    if (texture_id != m_texture) {
+      // Not a texture that we manage, so we can't know if it has storage.
+      std::vector<unsigned char> pixels(transfer.size);
+      transfer.fill(pixels.data());
+      glTexImage2D(GL_TEXTURE_2D, 0, transfer.internal_format, w, h, 0, transfer.format, transfer.type, pixels.data());
+      return;
+    }
+
+    if ((w <= 0) || (h <= 0))
+      return;
+
+    // Any pending rectangles are older than this image.
+    m_dirty_region.clear();
+
+    m_region_pixels = nullptr;
+
+    allocate_texture_storage(w, h, transfer.internal_format);
+
+    m_upload_ring.upload(transfer.size, 0, 0, w, h, transfer.format, transfer.type, transfer.fill);
+
+    m_texture_sample_weight = transfer.sample_weight;
+
+    m_texture_display_encoded = transfer.display_encoded;
+
+    m_present_uploaded = false;
+  }
+
+private:
+  bool setup_shader_program()
+  {
+    auto vert_shader = compile_shader(GL_VERTEX_SHADER, get_display_vert_shader(), std::cerr);
+
+    if (!vert_shader)
+      return false;
+
+    auto frag_shader = compile_shader(GL_FRAGMENT_SHADER, get_display_frag_shader(), std::cerr);
+
+    if (!frag_shader) {
+      glDeleteShader(vert_shader);
+      return false;
+    }
+
+    m_program = link_shader_program(vert_shader, frag_shader, std::cerr);
+
+    glDeleteShader(vert_shader);
+
+    glDeleteShader(frag_shader);
+
+    return m_program != 0;
+  }
+
+  void setup_buffers()
+  {
+    glGenBuffers(1, &m_vertex_buffer);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
+
+    float vertices[8];
+    vertices[0] = -1; // top left
+    vertices[1] = 1;
+    vertices[2] = -1; // bottom left
+    vertices[3] = -1;
+    vertices[4] = 1; // top right
+    vertices[5] = 1;
+    vertices[6] = 1; // bottom right
+    vertices[7] = -1;
+
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+  }
+
+  void setup_textures()
+  {
+    glActiveTexture(GL_TEXTURE0);
+
+    create_texture();
+
+    // clang-format off
+    float initColorBuf[3 * 4] {
+      1, 0, 0,  0, 1, 0,
+      0, 0, 1,  1, 1, 1
+    };
+    // clang-format on
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 2, 0, GL_RGB, GL_FLOAT, initColorBuf);
+
+    // Byte rows are not padded to four bytes by the load functions.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  }
+
+  DisplayTransform get_display_transform() const
+  {
+    DisplayTransform transform;
+    transform.sample_weight = m_sample_weight;
+    transform.tone_mapping = m_tone_mapping;
+    transform.srgb = m_srgb;
+    return transform;
+  }
+
+  /// Gets the format to upload floating point images in, measuring the
+  /// fastest one if it was not chosen by the application.
+  UploadFormat get_float_format()
+  {
+    if (m_upload_format != UploadFormat::automatic)
+      return m_upload_format;
+
+    return get_upload_preferences().float_format;
+  }
+
+  ByteLayout get_byte_layout() { return get_upload_preferences().byte_layout; }
+
+  /// Measures the upload formats the first time that they are needed. This
+  /// changes the texture binding.
+  const UploadPreferences& get_upload_preferences()
+  {
+    if (!m_upload_preferences_known) {
+      m_upload_preferences = window_blit::get_upload_preferences();
+      m_upload_preferences_known = true;
+    }
+
+    return m_upload_preferences;
+  }
+
+  void create_texture()
+  {
+    glGenTextures(1, &m_texture);
+
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  }
+
+  /// Allocates the storage of @ref m_texture, if it does not already have the
+  /// given size and format. The texture is left bound to GL_TEXTURE_2D.
+  void allocate_texture_storage(int w, int h, GLenum internal_format)
+  {
+    if ((w == m_texture_w) && (h == m_texture_h) && (internal_format == m_texture_format)) {
+      glBindTexture(GL_TEXTURE_2D, m_texture);
+      return;
+    }
+
+    if (GLAD_GL_ARB_texture_storage) {
+      // Immutable storage can't be respecified, so the texture object is replaced instead.
+      glDeleteTextures(1, &m_texture);
+      create_texture();
+      glTexStorage2D(GL_TEXTURE_2D, 1, internal_format, w, h);
+    } else {
+      glBindTexture(GL_TEXTURE_2D, m_texture);
+      glTexImage2D(GL_TEXTURE_2D, 0, internal_format, w, h, 0, GL_RGB, GL_FLOAT, nullptr);
+    }
+
+    m_texture_w = w;
+    m_texture_h = h;
+    m_texture_format = internal_format;
+  }
+
+  static std::string get_png_path()
+  {
+    for (int i = 0; i < 1024; i++) {
+
+      std::ostringstream stream;
+
+      stream << "snapshot-";
+      stream << std::setfill('0') << std::setw(4) << i;
+      stream << ".png";
+
+      auto path = stream.str();
+
+      if (!file_exists(path))
+        return path;
+    }
+
+    return "";
+  }
+
+  static bool file_exists(const std::string& path)
+  {
+    std::ifstream file(path.c_str());
+
+    return file.good();
+  }
+
+private:
+  GLuint m_vertex_buffer = 0;
+
+  GLuint m_texture = 0;
+
+  /// The size and internal format of the storage currently allocated for @ref m_texture.
+  int m_texture_w = 0;
+
+  int m_texture_h = 0;
+
+  GLenum m_texture_format = GL_NONE;
+
+  UploadRing m_upload_ring;
+
+  /// Only created when uploads are done asynchronously.
+  std::unique_ptr<UploadThread> m_upload_thread;
+
+  /// Whether the texture from the upload thread is the latest image, as
+  /// opposed to the one uploaded on the render thread.
+  bool m_present_uploaded = false;
+
+  /// The framebuffer returned by @ref map_framebuffer, until it is unmapped.
+  MappedFramebuffer m_mapped_framebuffer;
+
+  /// The rectangles of @ref m_region_pixels to upload once rendering is done.
+  DirtyRegion m_dirty_region;
+
+  const void* m_region_pixels = nullptr;
+
+  bool m_region_bytes = false;
+
+  int m_region_w = 0;
+
+  int m_region_h = 0;
+
+  GLuint m_program = 0;
+
+  GLint m_pos_attr_location = -1;
+
+  GLint m_sample_weight_uniform_location = -1;
+
+  float m_sample_weight = 1;
+
+  /// The sample weight that was already applied to the texels while packing them.
+  float m_texture_sample_weight = 1;
+
+  /// Whether the whole display transform was applied to the texels on the CPU.
+  bool m_texture_display_encoded = false;
+
+  UploadFormat m_upload_format = UploadFormat::rgb32f;
+
+  UploadPreferences m_upload_preferences;
+
+  bool m_upload_preferences_known = false;
+
+  GLint m_tone_mapping_location = -1;
+
+  float m_tone_mapping = 1.0f;
+
+  GLint m_srgb_location = -1;
+
+  float m_srgb = 1;
+
+  std::unique_ptr<Camera> m_camera;
+
+  /// The time the camera was last moved, in seconds, as returned by glfwGetTime.
+  double m_camera_time = 0;
+
+  /// The input events that arrived since the last frame.
+  InputQueue m_input_queue;
+
+  /// The events being handled, kept to reuse its memory.
+  std::vector<InputEvent> m_input_events;
+
+  /// Guards the camera, which the render thread reads while the window thread moves it.
+  mutable std::mutex m_camera_mutex;
+
+  /// Whether the app is run without a window or a context, in which case
+  /// frames are only ever stored in @ref m_frames.
+  bool m_headless = false;
+
+  /// Whether the app is run without a window, with or without a context. The
+  /// frames then have no window size to scale, so they are rendered at the
+  /// requested resolution.
+  bool m_windowless = false;
+
+  /// The number of threads that the app should render with, or zero to leave it to the app.
+  int m_pixel_thread_count = 0;
+
+  /// Whether @ref AppBase::render should be called on @ref m_render_thread.
+  bool m_threaded_render = false;
+
+  std::unique_ptr<RenderThread> m_render_thread;
+
+  /// Guards @ref m_render_thread against @ref invalidate, which may be called
+  /// from any thread. Only the window thread changes the pointer, so it reads
+  /// it without locking.
+  std::mutex m_render_thread_mutex;
+
+  /// The share of the render workers that this view gets, relative to the other views.
+  float m_render_priority = 1;
+
+  /// Hands the frames from the render thread over to the window thread.
+  TripleBuffer<RenderedFrame> m_frames;
+
+  /// The sample weight of the last frame from the render thread that was loaded.
+  float m_frame_sample_weight = 1;
+
+  /// Whether the frame being rendered is mapped, on the render thread.
+  bool m_frame_mapped = false;
+
+  /// Guards the members below, which are shared with the render thread.
+  std::mutex m_render_mutex;
+
+  int m_render_w = 0;
+
+  int m_render_h = 0;
+
+  std::atomic<bool> m_camera_change_pending{ false };
+
+  /// Incremented each time the image is invalidated.
+  std::atomic<unsigned int> m_generation{ 0 };
+
+  /// The generation that the image converged in, if it did. The image is
+  /// converged for as long as this matches @ref m_generation.
+  std::atomic<unsigned int> m_converged_generation{ ~0u };
+
+  /// Whether @ref AppBase::set_converged was called during the current call to @ref AppBase::render.
+  bool m_converge_requested = false;
+
+  /// Sizes the slices of progressive frames. Only used by the thread that calls @ref AppBase::render.
+  SliceController m_slice_controller;
+
+  /// Atomic since it may be set from the window thread while the render thread reads it.
+  std::atomic<float> m_frame_budget{ 1.0f / 60.0f };
+
+  BufferPool m_buffer_pool;
+
+  /// The last size of the window that was not zero.
+  int m_window_w = 0;
+
+  int m_window_h = 0;
+
+  BackgroundPolicy m_minimized_policy = BackgroundPolicy::pause;
+
+  BackgroundPolicy m_unfocused_policy = BackgroundPolicy::keep_running;
+
+  /// The policy that currently applies. Changes wake the render thread up.
+  std::atomic<BackgroundPolicy> m_background_policy{ BackgroundPolicy::keep_running };
+
+  std::atomic<float> m_throttled_frame_rate{ 5.0f };
+
+  /// When the next frame is due while throttled, as returned by glfwGetTime.
+  /// Only used by the thread that renders, except to compute the event timeout
+  /// without a render thread.
+  double m_next_throttled_frame = 0;
+
+  /// Whether @ref AppBase::finish_frame was skipped while accumulating in the background.
+  std::atomic<bool> m_finish_skipped{ false };
+
+  /// Whether a progressive frame was rendered by @ref render_slices.
+  bool m_frame_sliced = false;
+
+  /// The resolution that was last passed to @ref AppBase::on_resize. Only
+  /// used by the thread that calls @ref AppBase::render.
+  int m_render_size_w = 0;
+
+  int m_render_size_h = 0;
+
+  /// Scales the resolution when it is dynamic. Only used by the thread that calls @ref AppBase::render.
+  ResolutionController m_resolution_controller;
+
+  std::atomic<bool> m_dynamic_resolution{ false };
+
+  std::atomic<float> m_target_frame_time{ 1.0f / 60.0f };
+
+  /// The scale used while the resolution is not dynamic.
+  std::atomic<float> m_fixed_resolution_scale{ 1.0f };
+
+  /// The scale of the most recent frame.
+  std::atomic<float> m_resolution_scale{ 1.0f };
+
+  bool m_frame_clicked = false;
+
+  bool m_frame_pos_initialized = false;
+
+  glm::vec2 m_last_frame_pos = glm::vec2(0, 0);
+};
+
+AppBase::AppBase(GLFWwindow* window)
+  : App(window)
+  , m_impl(new AppBaseImpl(window))
+{}
+
+AppBase::~AppBase()
+{
+  delete m_impl;
+}
+
+bool
+AppBase::render_headless(int w, int h)
+{
+  return m_impl->render_headless(*this, w, h);
+}
+
+bool
+AppBase::get_headless_image(std::vector<unsigned char>& rgba, int& w, int& h)
+{
+  return m_impl->get_headless_image(rgba, w, h);
+}
+
+void
+AppBase::set_camera_keyframe(const CameraKeyframe& keyframe, int frame)
+{
+  m_impl->set_camera_keyframe(*this, keyframe, frame);
+}
+
+void
+AppBase::set_pixel_thread_count(int thread_count)
+{
+  m_impl->m_pixel_thread_count = std::max(thread_count, 0);
+}
+
+void
+AppBase::render(GLuint texture_id, int w, int h)
+{
+  m_impl->render_slices(*this, texture_id, w, h);
+}
+
+bool
+AppBase::render_slice(int /* w */, int /* h */, int /* work */)
+{
+  return false;
+}
+
+void
+AppBase::finish_frame(GLuint /* texture_id */, int /* w */, int /* h */)
+{}
+
+void
+AppBase::set_frame_budget(float seconds)
+{
+  m_impl->set_frame_budget(seconds);
+}
+
+void
+AppBase::on_frame()
+{
+  m_impl->on_frame(*this);
+}
+
+void
+AppBase::on_key(int key, int /* scancode */, int action, int /* mods */)
+{
+  m_impl->on_key(key, action);
+}
+
+void
+AppBase::on_resize(int w, int h)
+{
+  return m_impl->on_resize(w, h);
+}
+
+void
+AppBase::on_close()
+{
+  m_impl->on_close(*this);
+}
+
+void
+AppBase::on_window_resize(int w, int h)
+{
+  m_impl->on_window_resize(w, h);
+}
+
+bool
+AppBase::is_idle()
+{
+  return m_impl->is_idle();
+}
+
+double
+AppBase::get_event_timeout()
+{
+  return m_impl->get_event_timeout();
+}
+
+bool
+AppBase::is_presenting()
+{
+  switch (m_impl->get_window_policy(get_glfw_window())) {
+    case BackgroundPolicy::keep_running:
+    case BackgroundPolicy::throttle:
+      break;
+    case BackgroundPolicy::pause:
+    case BackgroundPolicy::accumulate:
+      return false;
+  }
+
+  return App::is_presenting();
+}
+
+void
+AppBase::on_iconify(bool /* iconified */)
+{
+  m_impl->update_background_policy(get_glfw_window());
+}
+
+void
+AppBase::on_focus(bool /* focused */)
+{
+  m_impl->update_background_policy(get_glfw_window());
+}
+
+void
+AppBase::set_render_priority(float priority)
+{
+  m_impl->set_render_priority(priority);
+}
+
+void
+AppBase::set_minimized_policy(BackgroundPolicy policy)
+{
+  m_impl->m_minimized_policy = policy;
+
+  m_impl->update_background_policy(get_glfw_window());
+}
+
+void
+AppBase::set_unfocused_policy(BackgroundPolicy policy)
+{
+  m_impl->m_unfocused_policy = policy;
+
+  m_impl->update_background_policy(get_glfw_window());
+}
+
+void
+AppBase::set_throttled_frame_rate(float frames_per_second)
+{
+  m_impl->m_throttled_frame_rate = frames_per_second;
+}
+
+void
+AppBase::set_converged()
+{
+  m_impl->set_converged();
+}
+
+void
+AppBase::invalidate()
+{
+  m_impl->invalidate();
+}
+
+void
+AppBase::on_camera_change()
+{}
+
+void
+AppBase::on_frame_seed(unsigned int /* seed */)
+{}
+
+glm::vec3
+AppBase::get_camera_position() const
+{
+  return m_impl->get_camera_position();
+}
+
+glm::mat3
+AppBase::get_camera_rotation_transform() const
+{
+  return m_impl->get_camera_rotation_transform();
+}
+
+void
+AppBase::on_cursor_motion(double x, double y)
+{
+  if (!m_impl->frame_clicked())
+    return;
+
+  int xMax = 0;
+  int yMax = 0;
+  m_impl->get_window_size(*this, xMax, yMax);
+
+  // Queued, to be merged with the rest of the motion of this frame.
+  m_impl->on_cursor_motion(x / xMax, y / yMax);
+}
+
+void
+AppBase::on_cursor_button(int button, int action, int mods)
+{
+  m_impl->on_cursor_button(button, action, mods);
+}
+
+void
+AppBase::on_cursor_motion(double x, double y, double dx, double dy)
+{
+  m_impl->on_cursor_motion(x, y, dx, dy);
 }
 
 void
@@ -555,19 +2084,81 @@ AppBase::set_sample_weight(float sample_weight)
 void
 AppBase::set_tone_mapping(float tone_mapping)
 {
+  // Invalidated since the display transform may have been applied on the CPU.
+  if (m_impl->m_tone_mapping != tone_mapping)
+    m_impl->invalidate();
+
   m_impl->m_tone_mapping = tone_mapping;
 }
 
 void
 AppBase::set_srgb(float srgb_mask)
 {
+  if (m_impl->m_srgb != srgb_mask)
+    m_impl->invalidate();
+
   m_impl->m_srgb = srgb_mask;
 }
 
+DisplayTransform
+AppBase::get_display_transform() const
+{
+  return m_impl->get_display_transform();
+}
+
+void
+AppBase::set_dynamic_resolution(bool enabled)
+{
+  m_impl->m_dynamic_resolution = enabled;
+
+  m_impl->invalidate();
+}
+
+void
+AppBase::set_target_frame_time(float seconds)
+{
+  m_impl->m_target_frame_time = seconds;
+}
+
+void
+AppBase::set_resolution_scale(float scale)
+{
+  m_impl->m_fixed_resolution_scale = std::min(std::max(scale, 0.0f), 1.0f);
+
+  m_impl->invalidate();
+}
+
+float
+AppBase::get_resolution_scale() const
+{
+  return m_impl->m_resolution_scale;
+}
+
+int
+AppBase::get_pixel_thread_count() const
+{
+  return m_impl->m_pixel_thread_count;
+}
+
+void
+AppBase::set_upload_format(UploadFormat format)
+{
+  if (m_impl->m_upload_format != format)
+    m_impl->invalidate();
+
+  m_impl->m_upload_format = format;
+}
+
+BufferPool&
+AppBase::get_buffer_pool() noexcept
+{
+  return m_impl->m_buffer_pool;
+}
+
 void
 AppBase::load_rgb(const float* rgb, int w, int h, GLuint texture_id)
 {
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, w, h, 0, GL_RGB, GL_FLOAT, rgb);
+  m_impl->load_rgb(texture_id, rgb, w, h);
 }
 
 void
@@ -575,13 +2166,113 @@ AppBase::load_rgb(const glm::vec3* rgb, int w, int h, GLuint texture_id)
 {
   static_assert(sizeof(glm::vec3) == (sizeof(float) * 3));
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, w, h, 0, GL_RGB, GL_FLOAT, rgb);
+  m_impl->load_rgb(texture_id, &rgb[0].x, w, h);
 }
 
 void
 AppBase::load_rgb(const unsigned char* rgb, int w, int h, GLuint texture_id)
 {
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+  m_impl->load_rgb(texture_id, rgb, w, h);
+}
+
+void
+AppBase::load_rgba(const float* rgba, int w, int h, GLuint texture_id)
+{
+  m_impl->load_rgba(texture_id, rgba, w, h);
+}
+
+void
+AppBase::load_rgba(const glm::vec4* rgba, int w, int h, GLuint texture_id)
+{
+  static_assert(sizeof(glm::vec4) == (sizeof(float) * 4));
+
+  m_impl->load_rgba(texture_id, &rgba[0].x, w, h);
+}
+
+void
+AppBase::load_rgb_rows(const float* rgb, int w, int h, int y, int row_count, GLuint texture_id)
+{
+  m_impl->load_rgb_rows(texture_id, rgb, w, h, y, row_count);
+}
+
+void
+AppBase::load_rgb_rows(const glm::vec3* rgb, int w, int h, int y, int row_count, GLuint texture_id)
+{
+  m_impl->load_rgb_rows(texture_id, &rgb[0].x, w, h, y, row_count);
+}
+
+void
+AppBase::load_rgb_rows(const unsigned char* rgb, int w, int h, int y, int row_count, GLuint texture_id)
+{
+  m_impl->load_rgb_rows(texture_id, rgb, w, h, y, row_count);
+}
+
+void
+AppBase::set_async_upload(bool enabled)
+{
+  m_impl->set_async_upload(enabled, get_glfw_window());
+}
+
+void
+AppBase::set_threaded_render(bool enabled)
+{
+  m_impl->set_threaded_render(enabled, *this);
+}
+
+MappedFramebuffer
+AppBase::map_framebuffer(int w, int h)
+{
+  return m_impl->map_framebuffer(w, h);
+}
+
+void
+AppBase::unmap_framebuffer()
+{
+  m_impl->unmap_framebuffer();
+}
+
+void
+AppBase::load_rgb_region(const float* rgb, int w, int h, int x, int y, int region_w, int region_h, GLuint texture_id)
+{
+  DirtyRegion::Rect rect;
+  rect.x_min = x;
+  rect.y_min = y;
+  rect.x_max = x + region_w;
+  rect.y_max = y + region_h;
+
+  m_impl->load_rgb_region(texture_id, rgb, false, w, h, rect);
+}
+
+void
+AppBase::load_rgb_region(const glm::vec3* rgb,
+                         int w,
+                         int h,
+                         int x,
+                         int y,
+                         int region_w,
+                         int region_h,
+                         GLuint texture_id)
+{
+  load_rgb_region(&rgb[0].x, w, h, x, y, region_w, region_h, texture_id);
+}
+
+void
+AppBase::load_rgb_region(const unsigned char* rgb,
+                         int w,
+                         int h,
+                         int x,
+                         int y,
+                         int region_w,
+                         int region_h,
+                         GLuint texture_id)
+{
+  DirtyRegion::Rect rect;
+  rect.x_min = x;
+  rect.y_min = y;
+  rect.x_max = x + region_w;
+  rect.y_max = y + region_h;
+
+  m_impl->load_rgb_region(texture_id, rgb, true, w, h, rect);
 }
 
 } // namespace window_blit
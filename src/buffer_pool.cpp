@@ -0,0 +1,118 @@
+#include <window_blit/buffer_pool.hpp>
+
+#include <iterator>
+#include <new>
+
+namespace window_blit {
+
+namespace {
+
+/// The smallest size class. Smaller blocks are not worth pooling, but are
+/// still handed out so that callers do not have to check.
+constexpr std::size_t g_min_size_class = 4096;
+
+/// Large enough for aligned vector loads and to keep blocks off each other's cache lines.
+constexpr std::align_val_t g_alignment{ 64 };
+
+/// The number of size classes per power of two.
+constexpr std::size_t g_classes_per_octave = 4;
+
+} // namespace
+
+BufferPool::BufferPool(std::size_t max_cached_size)
+  : m_max_cached_size(max_cached_size)
+{}
+
+BufferPool::~BufferPool()
+{
+  for (const auto& free_block : m_free_blocks)
+    ::operator delete(free_block.second, g_alignment);
+}
+
+void*
+BufferPool::acquire(std::size_t size, std::size_t& capacity)
+{
+  capacity = 0;
+
+  if (!size)
+    return nullptr;
+
+  const std::size_t size_class = get_size_class(size);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Blocks that are more than twice as large are left for larger buffers.
+    auto it = m_free_blocks.lower_bound(size_class);
+
+    if ((it != m_free_blocks.end()) && (it->first <= (size_class * 2))) {
+
+      void* block = it->second;
+
+      capacity = it->first;
+
+      m_cached_size -= it->first;
+
+      m_free_blocks.erase(it);
+
+      return block;
+    }
+  }
+
+  void* block = ::operator new(size_class, g_alignment, std::nothrow);
+
+  if (block)
+    capacity = size_class;
+
+  return block;
+}
+
+void
+BufferPool::release(void* block, std::size_t capacity)
+{
+  if (!block)
+    return;
+
+  if (capacity > m_max_cached_size) {
+    ::operator delete(block, g_alignment);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // The block that was just released is the most likely to be needed again,
+  // so the largest of the others are freed to make room for it.
+  while ((m_cached_size + capacity) > m_max_cached_size) {
+
+    auto largest = std::prev(m_free_blocks.end());
+
+    m_cached_size -= largest->first;
+
+    ::operator delete(largest->second, g_alignment);
+
+    m_free_blocks.erase(largest);
+  }
+
+  m_free_blocks.emplace(capacity, block);
+
+  m_cached_size += capacity;
+}
+
+std::size_t
+BufferPool::get_size_class(std::size_t size) noexcept
+{
+  if (size <= g_min_size_class)
+    return g_min_size_class;
+
+  // The largest power of two below the size.
+  std::size_t octave = g_min_size_class;
+
+  while ((octave * 2) < size)
+    octave *= 2;
+
+  const std::size_t step = octave / g_classes_per_octave;
+
+  return octave + (((size - octave) + (step - 1)) / step) * step;
+}
+
+} // namespace window_blit
@@ -0,0 +1,76 @@
+#include "dirty_region.hpp"
+
+#include <algorithm>
+
+namespace window_blit {
+
+namespace {
+
+/// Past this number of rectangles, the per-upload overhead outweighs the
+/// bandwidth saved by keeping them apart, so they are merged into one.
+const std::size_t g_max_rects = 32;
+
+DirtyRegion::Rect
+merge(const DirtyRegion::Rect& a, const DirtyRegion::Rect& b)
+{
+  DirtyRegion::Rect out;
+  out.x_min = std::min(a.x_min, b.x_min);
+  out.y_min = std::min(a.y_min, b.y_min);
+  out.x_max = std::max(a.x_max, b.x_max);
+  out.y_max = std::max(a.y_max, b.y_max);
+  return out;
+}
+
+} // namespace
+
+void
+DirtyRegion::add(int x, int y, int w, int h, int bounds_w, int bounds_h)
+{
+  Rect rect;
+  rect.x_min = std::max(x, 0);
+  rect.y_min = std::max(y, 0);
+  rect.x_max = std::min(x + w, bounds_w);
+  rect.y_max = std::min(y + h, bounds_h);
+
+  if ((rect.width() <= 0) || (rect.height() <= 0))
+    return;
+
+  // Merging can make the rectangle overlap ones that were checked earlier, so
+  // this repeats until nothing else merges.
+  bool merged = true;
+
+  while (merged) {
+
+    merged = false;
+
+    for (std::size_t i = 0; i < m_rects.size(); i++) {
+
+      const Rect candidate = merge(rect, m_rects[i]);
+
+      if (candidate.area() > (rect.area() + m_rects[i].area()))
+        continue;
+
+      rect = candidate;
+
+      m_rects.erase(m_rects.begin() + i);
+
+      merged = true;
+
+      break;
+    }
+  }
+
+  m_rects.emplace_back(rect);
+
+  if (m_rects.size() > g_max_rects) {
+
+    Rect bounds = m_rects[0];
+
+    for (const auto& r : m_rects)
+      bounds = merge(bounds, r);
+
+    m_rects.assign(1, bounds);
+  }
+}
+
+} // namespace window_blit
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+
+namespace window_blit {
+
+/// Accumulates the rectangles of an image that have changed.
+///
+/// @details Rectangles are merged as they are added, whenever the merged
+/// rectangle is no larger than the two rectangles it replaces. This joins
+/// neighboring tiles into larger uploads without uploading unchanged pixels.
+class DirtyRegion final
+{
+public:
+  /// A rectangle, with the maximum coordinates being exclusive.
+  struct Rect final
+  {
+    int x_min = 0;
+
+    int y_min = 0;
+
+    int x_max = 0;
+
+    int y_max = 0;
+
+    int width() const noexcept { return x_max - x_min; }
+
+    int height() const noexcept { return y_max - y_min; }
+
+    long long area() const noexcept { return (long long)width() * height(); }
+  };
+
+  /// Adds a rectangle, clipped to the bounds of a @p bounds_w by @p bounds_h image.
+  void add(int x, int y, int w, int h, int bounds_w, int bounds_h);
+
+  void clear() noexcept { m_rects.clear(); }
+
+  bool empty() const noexcept { return m_rects.empty(); }
+
+  const std::vector<Rect>& rects() const noexcept { return m_rects; }
+
+private:
+  std::vector<Rect> m_rects;
+};
+
+} // namespace window_blit
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <window_blit/display_transform.hpp>
+
+namespace window_blit {
+
+/// The implementations of @ref encode_display_rgba8, one for each instruction
+/// set. Normally the fastest one that the CPU supports is used.
+enum class DisplayKernel
+{
+  scalar,
+  sse2,
+  avx2,
+  /// Only built for 64-bit ARM, and not yet checked against the shader on ARM
+  /// hardware. See the display transform check.
+  neon
+};
+
+/// Indicates whether a kernel was built into the library and is supported by the CPU.
+bool
+is_display_kernel_supported(DisplayKernel kernel);
+
+const char*
+get_display_kernel_name(DisplayKernel kernel);
+
+/// Encodes pixels like @ref encode_display_rgba8, but with the given kernel
+/// and on the calling thread, so that each kernel can be compared with the
+/// shader. Nothing is encoded if the kernel is not supported.
+void
+encode_display_rgba8(DisplayKernel kernel,
+                     const float* rgb,
+                     std::uint8_t* rgba,
+                     std::size_t pixel_count,
+                     const DisplayTransform& transform,
+                     int channel_count = 3);
+
+} // namespace window_blit
@@ -0,0 +1,777 @@
+#include <window_blit/display_transform.hpp>
+
+#include "display_kernel.hpp"
+#include "worker_pool.hpp"
+
+#include <algorithm>
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define WINDOWBLIT_DISPLAY_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// The AVX2 kernel is compiled for the instruction set with a function
+// attribute, so that it can be selected at runtime without building the
+// library for AVX2.
+#if defined(WINDOWBLIT_DISPLAY_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define WINDOWBLIT_DISPLAY_AVX2 1
+#define WINDOWBLIT_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(WINDOWBLIT_DISPLAY_SSE2) && defined(_MSC_VER)
+#define WINDOWBLIT_DISPLAY_AVX2 1
+#define WINDOWBLIT_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+// Only 64-bit ARM has a vector division, which the tone mapping needs. This
+// kernel has not been built or run on ARM yet, so it is only compiled with
+// WINDOWBLIT_NEON until the display transform check passes there. Otherwise,
+// ARM uses the scalar kernel.
+#if defined(WINDOWBLIT_ENABLE_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#define WINDOWBLIT_DISPLAY_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace window_blit {
+
+namespace {
+
+// The constants of the Hable tone mapping curve.
+const float g_a = 0.15f;
+const float g_b = 0.50f;
+const float g_c = 0.10f;
+const float g_d = 0.20f;
+const float g_e = 0.02f;
+const float g_f = 0.30f;
+
+const float g_srgb_cutoff = 0.0031308f;
+
+/// Used to keep the divisions of the tone mapping away from zero.
+const float g_epsilon = 1e-6f;
+
+/// The number of pixels that each thread encodes at a time. Large enough
+/// that handing out the chunks is cheap, and small enough that a 4K frame
+/// is split into a couple hundred of them, so the threads finish together.
+const std::size_t g_chunk_pixel_count = 32768;
+
+float
+hable_tone_map(float x)
+{
+  return ((x * (g_a * x + g_c * g_b) + g_d * g_e) / (x * (g_a * x + g_b) + g_d * g_f)) - g_e / g_f;
+}
+
+float
+mix(float a, float b, float t)
+{
+  return a + (b - a) * t;
+}
+
+float
+to_srgb(float x)
+{
+  return (x < g_srgb_cutoff) ? (x * 12.92f) : ((1.055f * std::pow(std::max(x, 0.0f), 1.0f / 2.4f)) - 0.055f);
+}
+
+std::uint8_t
+to_unorm8(float x)
+{
+  // Written so that NaN becomes zero.
+  x = (x > 0.0f) ? std::min(x, 1.0f) : 0.0f;
+
+  return std::uint8_t((x * 255.0f) + 0.5f);
+}
+
+void
+encode_scalar(const float* rgb,
+              std::uint8_t* rgba,
+              std::size_t pixel_count,
+              const DisplayTransform& transform,
+              std::size_t stride)
+{
+  for (std::size_t i = 0; i < pixel_count; i++) {
+
+    float color[3]{ rgb[(i * stride) + 0] * transform.sample_weight,
+                    rgb[(i * stride) + 1] * transform.sample_weight,
+                    rgb[(i * stride) + 2] * transform.sample_weight };
+
+    float sig = std::max(color[0], std::max(color[1], color[2]));
+
+    const float luma = (color[0] * 0.2126f) + (color[1] * 0.7152f) + (color[2] * 0.0722f);
+
+    float coeff = std::max(sig - 0.18f, g_epsilon) / std::max(sig, g_epsilon);
+
+    coeff = std::pow(coeff, 20.0f);
+
+    sig = std::max(mix(sig, luma, coeff), g_epsilon);
+
+    const float scale = hable_tone_map(sig) / sig;
+
+    for (int c = 0; c < 3; c++) {
+
+      const float tone_mapped = mix(color[c], luma, coeff) * scale;
+
+      const float ldr = mix(color[c], tone_mapped, transform.tone_mapping);
+
+      rgba[(i * 4) + c] = to_unorm8(mix(ldr, to_srgb(ldr), transform.srgb));
+    }
+
+    rgba[(i * 4) + 3] = 255;
+  }
+}
+
+#ifdef WINDOWBLIT_DISPLAY_SSE2
+
+__m128
+select_ps(__m128 mask, __m128 a, __m128 b)
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+__m128
+mix_ps(__m128 a, __m128 b, __m128 t)
+{
+  return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+/// The base 2 logarithm of positive values, accurate to about 1e-7.
+__m128
+log2_ps(__m128 x)
+{
+  const __m128i bits = _mm_castps_si128(x);
+
+  __m128i exponent = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+
+  // The mantissa is moved into [sqrt(0.5), sqrt(2)), where the series below converges fastest.
+  __m128 m =
+    _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+
+  const __m128 is_large = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+
+  m = select_ps(is_large, _mm_mul_ps(m, _mm_set1_ps(0.5f)), m);
+
+  // The mask is minus one where the mantissa was halved.
+  exponent = _mm_sub_epi32(exponent, _mm_castps_si128(is_large));
+
+  // ln(m) = 2 * atanh((m - 1) / (m + 1))
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 s = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+  const __m128 s2 = _mm_mul_ps(s, s);
+
+  __m128 p = _mm_set1_ps(2.0f / 7.0f);
+  p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(2.0f / 5.0f));
+  p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(2.0f / 3.0f));
+  p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(2.0f));
+  p = _mm_mul_ps(p, s);
+
+  return _mm_add_ps(_mm_cvtepi32_ps(exponent), _mm_mul_ps(p, _mm_set1_ps(1.44269504f)));
+}
+
+/// Two to the power of values in the range of normal floats, accurate to about 1e-7.
+__m128
+exp2_ps(__m128 y)
+{
+  const __m128i n = _mm_cvtps_epi32(y);
+
+  const __m128 t = _mm_mul_ps(_mm_sub_ps(y, _mm_cvtepi32_ps(n)), _mm_set1_ps(0.69314718f));
+
+  __m128 p = _mm_set1_ps(1.0f / 720.0f);
+  p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.0f / 120.0f));
+  p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.0f / 24.0f));
+  p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.0f / 6.0f));
+  p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(0.5f));
+  p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.0f));
+  p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.0f));
+
+  const __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+
+  return _mm_mul_ps(p, scale);
+}
+
+__m128
+hable_tone_map_ps(__m128 x)
+{
+  const __m128 a = _mm_set1_ps(g_a);
+
+  const __m128 num =
+    _mm_add_ps(_mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(a, x), _mm_set1_ps(g_c * g_b))), _mm_set1_ps(g_d * g_e));
+  const __m128 den = _mm_add_ps(_mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(a, x), _mm_set1_ps(g_b))), _mm_set1_ps(g_d * g_f));
+
+  return _mm_sub_ps(_mm_div_ps(num, den), _mm_set1_ps(g_e / g_f));
+}
+
+__m128
+to_srgb_ps(__m128 x)
+{
+  const __m128 lower = _mm_mul_ps(x, _mm_set1_ps(12.92f));
+
+  const __m128 power =
+    exp2_ps(_mm_mul_ps(log2_ps(_mm_max_ps(x, _mm_set1_ps(g_srgb_cutoff))), _mm_set1_ps(1.0f / 2.4f)));
+
+  const __m128 higher = _mm_sub_ps(_mm_mul_ps(power, _mm_set1_ps(1.055f)), _mm_set1_ps(0.055f));
+
+  return select_ps(_mm_cmplt_ps(x, _mm_set1_ps(g_srgb_cutoff)), lower, higher);
+}
+
+__m128i
+to_unorm8_ps(__m128 x)
+{
+  // The operand order makes NaN become zero.
+  x = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+
+  return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+void
+encode_sse2(const float* rgb,
+            std::uint8_t* rgba,
+            std::size_t pixel_count,
+            const DisplayTransform& transform,
+            std::size_t stride)
+{
+  const __m128 sample_weight = _mm_set1_ps(transform.sample_weight);
+  const __m128 tone_mapping = _mm_set1_ps(transform.tone_mapping);
+  const __m128 srgb = _mm_set1_ps(transform.srgb);
+  const __m128 epsilon = _mm_set1_ps(g_epsilon);
+
+  std::size_t i = 0;
+
+  for (; (i + 4) <= pixel_count; i += 4) {
+
+    const float* p = rgb + (i * stride);
+
+    __m128 color[3];
+
+    for (std::size_t c = 0; c < 3; c++)
+      color[c] = _mm_mul_ps(_mm_setr_ps(p[c], p[stride + c], p[(stride * 2) + c], p[(stride * 3) + c]), sample_weight);
+
+    __m128 sig = _mm_max_ps(color[0], _mm_max_ps(color[1], color[2]));
+
+    const __m128 luma = _mm_add_ps(_mm_add_ps(_mm_mul_ps(color[0], _mm_set1_ps(0.2126f)),
+                                              _mm_mul_ps(color[1], _mm_set1_ps(0.7152f))),
+                                   _mm_mul_ps(color[2], _mm_set1_ps(0.0722f)));
+
+    __m128 coeff =
+      _mm_div_ps(_mm_max_ps(_mm_sub_ps(sig, _mm_set1_ps(0.18f)), epsilon), _mm_max_ps(sig, epsilon));
+
+    // Raised to the 20th power by squaring.
+    const __m128 c2 = _mm_mul_ps(coeff, coeff);
+    const __m128 c5 = _mm_mul_ps(_mm_mul_ps(c2, c2), coeff);
+    const __m128 c10 = _mm_mul_ps(c5, c5);
+    coeff = _mm_mul_ps(c10, c10);
+
+    sig = _mm_max_ps(mix_ps(sig, luma, coeff), epsilon);
+
+    const __m128 scale = _mm_div_ps(hable_tone_map_ps(sig), sig);
+
+    __m128i out = _mm_set1_epi32(int(0xff000000u));
+
+    for (int c = 0; c < 3; c++) {
+
+      const __m128 tone_mapped = _mm_mul_ps(mix_ps(color[c], luma, coeff), scale);
+
+      const __m128 ldr = mix_ps(color[c], tone_mapped, tone_mapping);
+
+      out = _mm_or_si128(out, _mm_slli_epi32(to_unorm8_ps(mix_ps(ldr, to_srgb_ps(ldr), srgb)), c * 8));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + (i * 4)), out);
+  }
+
+  encode_scalar(rgb + (i * stride), rgba + (i * 4), pixel_count - i, transform, stride);
+}
+
+#endif // WINDOWBLIT_DISPLAY_SSE2
+
+#ifdef WINDOWBLIT_DISPLAY_AVX2
+
+// These mirror the SSE2 functions above, see there for comments.
+
+WINDOWBLIT_TARGET_AVX2 __m256
+mix_ps(__m256 a, __m256 b, __m256 t)
+{
+  return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t));
+}
+
+WINDOWBLIT_TARGET_AVX2 __m256
+log2_ps(__m256 x)
+{
+  const __m256i bits = _mm256_castps_si256(x);
+
+  __m256i exponent = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+
+  __m256 m = _mm256_castsi256_ps(
+    _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+
+  const __m256 is_large = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+
+  m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), is_large);
+
+  exponent = _mm256_sub_epi32(exponent, _mm256_castps_si256(is_large));
+
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 s = _mm256_div_ps(_mm256_sub_ps(m, one), _mm256_add_ps(m, one));
+  const __m256 s2 = _mm256_mul_ps(s, s);
+
+  __m256 p = _mm256_set1_ps(2.0f / 7.0f);
+  p = _mm256_add_ps(_mm256_mul_ps(p, s2), _mm256_set1_ps(2.0f / 5.0f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, s2), _mm256_set1_ps(2.0f / 3.0f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, s2), _mm256_set1_ps(2.0f));
+  p = _mm256_mul_ps(p, s);
+
+  return _mm256_add_ps(_mm256_cvtepi32_ps(exponent), _mm256_mul_ps(p, _mm256_set1_ps(1.44269504f)));
+}
+
+WINDOWBLIT_TARGET_AVX2 __m256
+exp2_ps(__m256 y)
+{
+  const __m256i n = _mm256_cvtps_epi32(y);
+
+  const __m256 t = _mm256_mul_ps(_mm256_sub_ps(y, _mm256_cvtepi32_ps(n)), _mm256_set1_ps(0.69314718f));
+
+  __m256 p = _mm256_set1_ps(1.0f / 720.0f);
+  p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(1.0f / 120.0f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(1.0f / 24.0f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(1.0f / 6.0f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(0.5f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(1.0f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(1.0f));
+
+  const __m256 scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23));
+
+  return _mm256_mul_ps(p, scale);
+}
+
+WINDOWBLIT_TARGET_AVX2 __m256
+hable_tone_map_ps(__m256 x)
+{
+  const __m256 a = _mm256_set1_ps(g_a);
+
+  const __m256 num = _mm256_add_ps(_mm256_mul_ps(x, _mm256_add_ps(_mm256_mul_ps(a, x), _mm256_set1_ps(g_c * g_b))),
+                                   _mm256_set1_ps(g_d * g_e));
+  const __m256 den =
+    _mm256_add_ps(_mm256_mul_ps(x, _mm256_add_ps(_mm256_mul_ps(a, x), _mm256_set1_ps(g_b))), _mm256_set1_ps(g_d * g_f));
+
+  return _mm256_sub_ps(_mm256_div_ps(num, den), _mm256_set1_ps(g_e / g_f));
+}
+
+WINDOWBLIT_TARGET_AVX2 __m256
+to_srgb_ps(__m256 x)
+{
+  const __m256 cutoff = _mm256_set1_ps(g_srgb_cutoff);
+
+  const __m256 lower = _mm256_mul_ps(x, _mm256_set1_ps(12.92f));
+
+  const __m256 power = exp2_ps(_mm256_mul_ps(log2_ps(_mm256_max_ps(x, cutoff)), _mm256_set1_ps(1.0f / 2.4f)));
+
+  const __m256 higher = _mm256_sub_ps(_mm256_mul_ps(power, _mm256_set1_ps(1.055f)), _mm256_set1_ps(0.055f));
+
+  return _mm256_blendv_ps(higher, lower, _mm256_cmp_ps(x, cutoff, _CMP_LT_OQ));
+}
+
+WINDOWBLIT_TARGET_AVX2 __m256i
+to_unorm8_ps(__m256 x)
+{
+  x = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+
+  return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+}
+
+WINDOWBLIT_TARGET_AVX2 void
+encode_avx2(const float* rgb,
+            std::uint8_t* rgba,
+            std::size_t pixel_count,
+            const DisplayTransform& transform,
+            std::size_t stride)
+{
+  const __m256 sample_weight = _mm256_set1_ps(transform.sample_weight);
+  const __m256 tone_mapping = _mm256_set1_ps(transform.tone_mapping);
+  const __m256 srgb = _mm256_set1_ps(transform.srgb);
+  const __m256 epsilon = _mm256_set1_ps(g_epsilon);
+
+  // Gathers one channel of eight interleaved pixels.
+  const __m256i channel_offsets =
+    _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(int(stride)));
+
+  std::size_t i = 0;
+
+  for (; (i + 8) <= pixel_count; i += 8) {
+
+    const float* p = rgb + (i * stride);
+
+    __m256 color[3]{ _mm256_mul_ps(_mm256_i32gather_ps(p + 0, channel_offsets, 4), sample_weight),
+                     _mm256_mul_ps(_mm256_i32gather_ps(p + 1, channel_offsets, 4), sample_weight),
+                     _mm256_mul_ps(_mm256_i32gather_ps(p + 2, channel_offsets, 4), sample_weight) };
+
+    __m256 sig = _mm256_max_ps(color[0], _mm256_max_ps(color[1], color[2]));
+
+    const __m256 luma = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(color[0], _mm256_set1_ps(0.2126f)),
+                                                    _mm256_mul_ps(color[1], _mm256_set1_ps(0.7152f))),
+                                      _mm256_mul_ps(color[2], _mm256_set1_ps(0.0722f)));
+
+    __m256 coeff = _mm256_div_ps(_mm256_max_ps(_mm256_sub_ps(sig, _mm256_set1_ps(0.18f)), epsilon),
+                                 _mm256_max_ps(sig, epsilon));
+
+    const __m256 c2 = _mm256_mul_ps(coeff, coeff);
+    const __m256 c5 = _mm256_mul_ps(_mm256_mul_ps(c2, c2), coeff);
+    const __m256 c10 = _mm256_mul_ps(c5, c5);
+    coeff = _mm256_mul_ps(c10, c10);
+
+    sig = _mm256_max_ps(mix_ps(sig, luma, coeff), epsilon);
+
+    const __m256 scale = _mm256_div_ps(hable_tone_map_ps(sig), sig);
+
+    __m256i out = _mm256_set1_epi32(int(0xff000000u));
+
+    for (int c = 0; c < 3; c++) {
+
+      const __m256 tone_mapped = _mm256_mul_ps(mix_ps(color[c], luma, coeff), scale);
+
+      const __m256 ldr = mix_ps(color[c], tone_mapped, tone_mapping);
+
+      out = _mm256_or_si256(out, _mm256_slli_epi32(to_unorm8_ps(mix_ps(ldr, to_srgb_ps(ldr), srgb)), c * 8));
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + (i * 4)), out);
+  }
+
+  encode_sse2(rgb + (i * stride), rgba + (i * 4), pixel_count - i, transform, stride);
+}
+
+bool
+has_avx2()
+{
+#ifdef _MSC_VER
+  int info[4]{};
+
+  __cpuid(info, 0);
+
+  if (info[0] < 7)
+    return false;
+
+  __cpuid(info, 1);
+
+  // The OS has to save the upper halves of the registers too.
+  const bool os_saves_ymm = (info[2] & (1 << 27)) && ((_xgetbv(0) & 6) == 6);
+
+  __cpuidex(info, 7, 0);
+
+  return os_saves_ymm && (info[1] & (1 << 5));
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // WINDOWBLIT_DISPLAY_AVX2
+
+#ifdef WINDOWBLIT_DISPLAY_NEON
+
+// These mirror the SSE2 functions above, see there for comments.
+
+float32x4_t
+mix_ps(float32x4_t a, float32x4_t b, float32x4_t t)
+{
+  return vfmaq_f32(a, vsubq_f32(b, a), t);
+}
+
+float32x4_t
+log2_ps(float32x4_t x)
+{
+  const uint32x4_t bits = vreinterpretq_u32_f32(x);
+
+  int32x4_t exponent = vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(127));
+
+  float32x4_t m =
+    vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007fffff)), vdupq_n_u32(0x3f800000)));
+
+  const uint32x4_t is_large = vcgtq_f32(m, vdupq_n_f32(1.41421356f));
+
+  m = vbslq_f32(is_large, vmulq_n_f32(m, 0.5f), m);
+
+  exponent = vsubq_s32(exponent, vreinterpretq_s32_u32(is_large));
+
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  const float32x4_t s = vdivq_f32(vsubq_f32(m, one), vaddq_f32(m, one));
+  const float32x4_t s2 = vmulq_f32(s, s);
+
+  float32x4_t p = vdupq_n_f32(2.0f / 7.0f);
+  p = vfmaq_f32(vdupq_n_f32(2.0f / 5.0f), p, s2);
+  p = vfmaq_f32(vdupq_n_f32(2.0f / 3.0f), p, s2);
+  p = vfmaq_f32(vdupq_n_f32(2.0f), p, s2);
+  p = vmulq_f32(p, s);
+
+  return vfmaq_f32(vcvtq_f32_s32(exponent), p, vdupq_n_f32(1.44269504f));
+}
+
+float32x4_t
+exp2_ps(float32x4_t y)
+{
+  const int32x4_t n = vcvtnq_s32_f32(y);
+
+  const float32x4_t t = vmulq_n_f32(vsubq_f32(y, vcvtq_f32_s32(n)), 0.69314718f);
+
+  float32x4_t p = vdupq_n_f32(1.0f / 720.0f);
+  p = vfmaq_f32(vdupq_n_f32(1.0f / 120.0f), p, t);
+  p = vfmaq_f32(vdupq_n_f32(1.0f / 24.0f), p, t);
+  p = vfmaq_f32(vdupq_n_f32(1.0f / 6.0f), p, t);
+  p = vfmaq_f32(vdupq_n_f32(0.5f), p, t);
+  p = vfmaq_f32(vdupq_n_f32(1.0f), p, t);
+  p = vfmaq_f32(vdupq_n_f32(1.0f), p, t);
+
+  const float32x4_t scale = vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(n, vdupq_n_s32(127)), 23));
+
+  return vmulq_f32(p, scale);
+}
+
+float32x4_t
+hable_tone_map_ps(float32x4_t x)
+{
+  const float32x4_t a = vdupq_n_f32(g_a);
+
+  const float32x4_t num = vfmaq_f32(vdupq_n_f32(g_d * g_e), x, vfmaq_f32(vdupq_n_f32(g_c * g_b), a, x));
+  const float32x4_t den = vfmaq_f32(vdupq_n_f32(g_d * g_f), x, vfmaq_f32(vdupq_n_f32(g_b), a, x));
+
+  return vsubq_f32(vdivq_f32(num, den), vdupq_n_f32(g_e / g_f));
+}
+
+float32x4_t
+to_srgb_ps(float32x4_t x)
+{
+  const float32x4_t cutoff = vdupq_n_f32(g_srgb_cutoff);
+
+  const float32x4_t lower = vmulq_n_f32(x, 12.92f);
+
+  const float32x4_t power = exp2_ps(vmulq_n_f32(log2_ps(vmaxq_f32(x, cutoff)), 1.0f / 2.4f));
+
+  const float32x4_t higher = vsubq_f32(vmulq_n_f32(power, 1.055f), vdupq_n_f32(0.055f));
+
+  return vbslq_f32(vcltq_f32(x, cutoff), lower, higher);
+}
+
+uint32x4_t
+to_unorm8_ps(float32x4_t x)
+{
+  // Unlike vmaxq_f32, this returns the number when the other operand is NaN.
+  x = vminq_f32(vmaxnmq_f32(x, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+
+  return vcvtq_u32_f32(vfmaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(255.0f)));
+}
+
+void
+encode_neon(const float* rgb,
+            std::uint8_t* rgba,
+            std::size_t pixel_count,
+            const DisplayTransform& transform,
+            std::size_t stride)
+{
+  const float32x4_t sample_weight = vdupq_n_f32(transform.sample_weight);
+  const float32x4_t tone_mapping = vdupq_n_f32(transform.tone_mapping);
+  const float32x4_t srgb = vdupq_n_f32(transform.srgb);
+  const float32x4_t epsilon = vdupq_n_f32(g_epsilon);
+
+  std::size_t i = 0;
+
+  for (; (i + 4) <= pixel_count; i += 4) {
+
+    const float* p = rgb + (i * stride);
+
+    float32x4_t color[3];
+
+    // The interleaved layouts are split into channels by the loads themselves.
+    if (stride == 3) {
+      const float32x4x3_t pixels = vld3q_f32(p);
+      for (int c = 0; c < 3; c++)
+        color[c] = vmulq_f32(pixels.val[c], sample_weight);
+    } else if (stride == 4) {
+      const float32x4x4_t pixels = vld4q_f32(p);
+      for (int c = 0; c < 3; c++)
+        color[c] = vmulq_f32(pixels.val[c], sample_weight);
+    } else {
+      for (std::size_t c = 0; c < 3; c++) {
+        const float channel[4]{ p[c], p[stride + c], p[(stride * 2) + c], p[(stride * 3) + c] };
+        color[c] = vmulq_f32(vld1q_f32(channel), sample_weight);
+      }
+    }
+
+    float32x4_t sig = vmaxq_f32(color[0], vmaxq_f32(color[1], color[2]));
+
+    float32x4_t luma = vmulq_n_f32(color[0], 0.2126f);
+    luma = vfmaq_f32(luma, color[1], vdupq_n_f32(0.7152f));
+    luma = vfmaq_f32(luma, color[2], vdupq_n_f32(0.0722f));
+
+    float32x4_t coeff = vdivq_f32(vmaxq_f32(vsubq_f32(sig, vdupq_n_f32(0.18f)), epsilon), vmaxq_f32(sig, epsilon));
+
+    const float32x4_t c2 = vmulq_f32(coeff, coeff);
+    const float32x4_t c5 = vmulq_f32(vmulq_f32(c2, c2), coeff);
+    const float32x4_t c10 = vmulq_f32(c5, c5);
+    coeff = vmulq_f32(c10, c10);
+
+    sig = vmaxq_f32(mix_ps(sig, luma, coeff), epsilon);
+
+    const float32x4_t scale = vdivq_f32(hable_tone_map_ps(sig), sig);
+
+    uint32x4_t out = vdupq_n_u32(0xff000000u);
+
+    for (int c = 0; c < 3; c++) {
+
+      const float32x4_t tone_mapped = vmulq_f32(mix_ps(color[c], luma, coeff), scale);
+
+      const float32x4_t ldr = mix_ps(color[c], tone_mapped, tone_mapping);
+
+      out = vorrq_u32(out, vshlq_u32(to_unorm8_ps(mix_ps(ldr, to_srgb_ps(ldr), srgb)), vdupq_n_s32(c * 8)));
+    }
+
+    vst1q_u8(rgba + (i * 4), vreinterpretq_u8_u32(out));
+  }
+
+  encode_scalar(rgb + (i * stride), rgba + (i * 4), pixel_count - i, transform, stride);
+}
+
+#endif // WINDOWBLIT_DISPLAY_NEON
+
+} // namespace
+
+namespace {
+
+/// Encodes pixels on the calling thread, with the fastest kernel that the CPU supports.
+void
+encode_range(const float* rgb,
+             std::uint8_t* rgba,
+             std::size_t pixel_count,
+             const DisplayTransform& transform,
+             std::size_t stride)
+{
+#if defined(WINDOWBLIT_DISPLAY_AVX2)
+
+  static const bool avx2 = has_avx2();
+
+  if (avx2)
+    encode_avx2(rgb, rgba, pixel_count, transform, stride);
+  else
+    encode_sse2(rgb, rgba, pixel_count, transform, stride);
+
+#elif defined(WINDOWBLIT_DISPLAY_SSE2)
+
+  encode_sse2(rgb, rgba, pixel_count, transform, stride);
+
+#elif defined(WINDOWBLIT_DISPLAY_NEON)
+
+  encode_neon(rgb, rgba, pixel_count, transform, stride);
+
+#else
+
+  encode_scalar(rgb, rgba, pixel_count, transform, stride);
+
+#endif
+}
+
+} // namespace
+
+bool
+is_display_kernel_supported(DisplayKernel kernel)
+{
+  switch (kernel) {
+    case DisplayKernel::scalar:
+      return true;
+    case DisplayKernel::sse2:
+#ifdef WINDOWBLIT_DISPLAY_SSE2
+      return true;
+#else
+      return false;
+#endif
+    case DisplayKernel::avx2:
+#ifdef WINDOWBLIT_DISPLAY_AVX2
+      return has_avx2();
+#else
+      return false;
+#endif
+    case DisplayKernel::neon:
+#ifdef WINDOWBLIT_DISPLAY_NEON
+      return true;
+#else
+      return false;
+#endif
+  }
+
+  return false;
+}
+
+const char*
+get_display_kernel_name(DisplayKernel kernel)
+{
+  switch (kernel) {
+    case DisplayKernel::scalar:
+      return "scalar";
+    case DisplayKernel::sse2:
+      return "SSE2";
+    case DisplayKernel::avx2:
+      return "AVX2";
+    case DisplayKernel::neon:
+      return "NEON";
+  }
+
+  return "";
+}
+
+void
+encode_display_rgba8(DisplayKernel kernel,
+                     const float* rgb,
+                     std::uint8_t* rgba,
+                     std::size_t pixel_count,
+                     const DisplayTransform& transform,
+                     int channel_count)
+{
+  if (!is_display_kernel_supported(kernel))
+    return;
+
+  const std::size_t stride = std::size_t(channel_count);
+
+  switch (kernel) {
+    case DisplayKernel::scalar:
+      encode_scalar(rgb, rgba, pixel_count, transform, stride);
+      break;
+    case DisplayKernel::sse2:
+#ifdef WINDOWBLIT_DISPLAY_SSE2
+      encode_sse2(rgb, rgba, pixel_count, transform, stride);
+#endif
+      break;
+    case DisplayKernel::avx2:
+#ifdef WINDOWBLIT_DISPLAY_AVX2
+      encode_avx2(rgb, rgba, pixel_count, transform, stride);
+#endif
+      break;
+    case DisplayKernel::neon:
+#ifdef WINDOWBLIT_DISPLAY_NEON
+      encode_neon(rgb, rgba, pixel_count, transform, stride);
+#endif
+      break;
+  }
+}
+
+void
+encode_display_rgba8(const float* rgb,
+                     std::uint8_t* rgba,
+                     std::size_t pixel_count,
+                     const DisplayTransform& transform,
+                     int channel_count)
+{
+  const std::size_t stride = std::size_t(channel_count);
+
+  const std::size_t chunk_count = (pixel_count + g_chunk_pixel_count - 1) / g_chunk_pixel_count;
+
+  // Small images, such as the rows of dirty regions, are not worth waking the workers for.
+  if (chunk_count <= 1) {
+    encode_range(rgb, rgba, pixel_count, transform, stride);
+    return;
+  }
+
+  WorkerPool::run(chunk_count, [rgb, rgba, pixel_count, &transform, stride](std::size_t chunk) {
+    const std::size_t first = chunk * g_chunk_pixel_count;
+    const std::size_t count = std::min(g_chunk_pixel_count, pixel_count - first);
+    encode_range(rgb + (first * stride), rgba + (first * 4), count, transform, stride);
+  });
+}
+
+} // namespace window_blit
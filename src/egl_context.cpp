@@ -0,0 +1,186 @@
+#include "egl_context.hpp"
+
+#include <glad/glad.h>
+
+#ifdef WINDOWBLIT_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <iostream>
+
+#include <cstring>
+
+namespace window_blit {
+
+namespace {
+
+/// The context that was last made current on this thread by @ref EglContext::create.
+thread_local const EglContext* t_current_context = nullptr;
+
+#ifdef WINDOWBLIT_EGL
+
+bool
+has_extension(const char* extensions, const char* name)
+{
+  if (!extensions)
+    return false;
+
+  const std::size_t length = std::strlen(name);
+
+  for (const char* match = std::strstr(extensions, name); match; match = std::strstr(match + length, name)) {
+
+    const bool starts_word = (match == extensions) || (match[-1] == ' ');
+
+    const bool ends_word = (match[length] == ' ') || (match[length] == 0);
+
+    if (starts_word && ends_word)
+      return true;
+  }
+
+  return false;
+}
+
+EGLDisplay
+get_display()
+{
+  const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+  if (has_extension(client_extensions, "EGL_EXT_platform_base") &&
+      has_extension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+
+    auto get_platform_display =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+    if (get_platform_display) {
+
+      EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+      if (display != EGL_NO_DISPLAY)
+        return display;
+    }
+  }
+
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+#endif // WINDOWBLIT_EGL
+
+} // namespace
+
+#ifdef WINDOWBLIT_EGL
+
+std::unique_ptr<EglContext>
+EglContext::create()
+{
+  std::unique_ptr<EglContext> context(new EglContext());
+
+  EGLDisplay display = get_display();
+
+  if ((display == EGL_NO_DISPLAY) || !eglInitialize(display, nullptr, nullptr)) {
+    std::cerr << "Failed to initialize an EGL display" << std::endl;
+    return nullptr;
+  }
+
+  context->m_display = display;
+
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    std::cerr << "The EGL display does not support OpenGL" << std::endl;
+    return nullptr;
+  }
+
+  const bool surfaceless = has_extension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+  const EGLint config_attribs[] = { EGL_SURFACE_TYPE,
+                                    surfaceless ? 0 : EGL_PBUFFER_BIT,
+                                    EGL_RENDERABLE_TYPE,
+                                    EGL_OPENGL_BIT,
+                                    EGL_NONE };
+
+  EGLConfig config = nullptr;
+
+  EGLint config_count = 0;
+
+  if (!eglChooseConfig(display, config_attribs, &config, 1, &config_count) || (config_count < 1)) {
+    std::cerr << "Failed to find an EGL config for OpenGL" << std::endl;
+    return nullptr;
+  }
+
+  context->m_context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+
+  if (context->m_context == EGL_NO_CONTEXT) {
+    std::cerr << "Failed to create an EGL context" << std::endl;
+    return nullptr;
+  }
+
+  if (!surfaceless) {
+
+    const EGLint pbuffer_attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+
+    context->m_surface = eglCreatePbufferSurface(display, config, pbuffer_attribs);
+
+    if (context->m_surface == EGL_NO_SURFACE) {
+      std::cerr << "Failed to create an EGL pbuffer surface" << std::endl;
+      return nullptr;
+    }
+  }
+
+  if (!eglMakeCurrent(display, context->m_surface, context->m_surface, context->m_context)) {
+    std::cerr << "Failed to make the EGL context current" << std::endl;
+    return nullptr;
+  }
+
+  t_current_context = context.get();
+
+  if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+    std::cerr << "Failed to load the OpenGL functions of the EGL context" << std::endl;
+    return nullptr;
+  }
+
+  return context;
+}
+
+EglContext::~EglContext()
+{
+  if (t_current_context == this)
+    t_current_context = nullptr;
+
+  if (!m_display)
+    return;
+
+  eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+  if (m_surface)
+    eglDestroySurface(m_display, m_surface);
+
+  if (m_context)
+    eglDestroyContext(m_display, m_context);
+
+  eglTerminate(m_display);
+}
+
+#else // WINDOWBLIT_EGL
+
+std::unique_ptr<EglContext>
+EglContext::create()
+{
+  std::cerr << "The library was built without EGL, see WINDOWBLIT_EGL" << std::endl;
+
+  return nullptr;
+}
+
+EglContext::~EglContext()
+{
+  if (t_current_context == this)
+    t_current_context = nullptr;
+}
+
+#endif // WINDOWBLIT_EGL
+
+bool
+EglContext::is_any_current() noexcept
+{
+  return t_current_context != nullptr;
+}
+
+} // namespace window_blit
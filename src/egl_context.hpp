@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+
+namespace window_blit {
+
+/// An OpenGL context without a window or a display server, created with EGL.
+///
+/// @details Mesa's surfaceless platform is used when it is available, which
+/// works on llvmpipe with no GPU at all, and otherwise the default display.
+/// The context is made current without a surface if the display supports it,
+/// and with a small pbuffer surface otherwise, since the frames are drawn into
+/// a framebuffer object either way. The context is a compatibility profile,
+/// since the shaders are GLSL 1.20.
+class EglContext final
+{
+public:
+  /// Creates a context, makes it current and loads the GL functions for it.
+  /// Errors are printed to the standard error.
+  ///
+  /// @return The context, or null if it could not be created or if the
+  /// library was built without EGL.
+  static std::unique_ptr<EglContext> create();
+
+  /// Indicates whether a context created with @ref create is current on this
+  /// thread, which apps without a window can then draw with.
+  static bool is_any_current() noexcept;
+
+  EglContext(const EglContext&) = delete;
+
+  ~EglContext();
+
+private:
+  EglContext() = default;
+
+  /// The EGL handles, which are pointers in the EGL headers, kept here as
+  /// opaque pointers so that including this does not require EGL.
+  void* m_display = nullptr;
+
+  void* m_context = nullptr;
+
+  void* m_surface = nullptr;
+};
+
+} // namespace window_blit
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <ostream>
+
+namespace window_blit {
+
+/// The times of a run of frames, for comparing runs of the same work.
+class FrameStatistics final
+{
+public:
+  void add(double seconds)
+  {
+    m_min_time = m_frame_count ? std::min(m_min_time, seconds) : seconds;
+
+    m_max_time = std::max(m_max_time, seconds);
+
+    m_total_time += seconds;
+
+    m_frame_count++;
+  }
+
+  int get_frame_count() const noexcept { return m_frame_count; }
+
+  /// Prints the number of frames and how long they took, as in "120 frames in
+  /// 2 s (16.7 ms per frame, 15.9 ms min, 31.2 ms max)".
+  void print(std::ostream& stream) const
+  {
+    stream << m_frame_count << " frames in " << m_total_time << " s ("
+           << (m_frame_count ? ((m_total_time * 1000) / m_frame_count) : 0.0) << " ms per frame, "
+           << (m_min_time * 1000) << " ms min, " << (m_max_time * 1000) << " ms max)";
+  }
+
+private:
+  int m_frame_count = 0;
+
+  double m_total_time = 0;
+
+  double m_min_time = 0;
+
+  double m_max_time = 0;
+};
+
+} // namespace window_blit
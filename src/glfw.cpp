@@ -2,6 +2,11 @@
 
 #include <window_blit/app.hpp>
 
+#include "frame_statistics.hpp"
+#include "imgui_window.hpp"
+#include "input_recording.hpp"
+#include "render_thread.hpp"
+
 #include <glad/glad.h>
 
 #include <GLFW/glfw3.h>
@@ -12,36 +17,101 @@
 #include <imgui_impl_opengl3.h>
 #endif
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <sstream>
+#include <thread>
 
+#include <cmath>
 #include <cstdlib>
 
 namespace window_blit {
 
 namespace {
 
+/// The number of frames that are still drawn after an event while the app is
+/// idle, so that ImGui can finish responding to it.
+constexpr int g_idle_frame_count = 3;
+
 void
 glfw_error_callback(int /* code */, const char* description)
 {
   std::cerr << "GLFW error: " << description << std::endl;
 }
 
+/// The recording that the input of the windows is written to, if there is one.
+InputRecorder* g_input_recorder = nullptr;
+
+/// Whether the input of the windows comes from a recording, in which case their own input is ignored.
+bool g_input_replayed = false;
+
+/// The windows in the order that they were created, which is how recordings refer to them.
+std::vector<GLFWwindow*> g_windows;
+
+int
+get_window_index(GLFWwindow* window)
+{
+  return int(std::find(g_windows.begin(), g_windows.end(), window) - g_windows.begin());
+}
+
+/// Records an input event, if the input is being recorded, and passes it on to the app of the window.
+void
+handle_input(GLFWwindow* window, InputRecord& record)
+{
+  // Resizes too, since the replay passes the recorded ones to the apps itself.
+  if (g_input_replayed)
+    return;
+
+  if (g_input_recorder) {
+    record.window = get_window_index(window);
+    record.time = glfwGetTime();
+    g_input_recorder->write(record);
+  }
+
+  App* app = (App*)glfwGetWindowUserPointer(window);
+
+  dispatch_input(*app, record);
+}
+
 void
 glfw_resize_callback(GLFWwindow* window, int w, int h)
+{
+  InputRecord record;
+  record.type = InputRecord::Type::resize;
+  record.w = w;
+  record.h = h;
+
+  handle_input(window, record);
+}
+
+void
+glfw_iconify_callback(GLFWwindow* window, int iconified)
 {
   App* app = (App*)glfwGetWindowUserPointer(window);
 
-  app->on_resize(w, h);
+  app->on_iconify(iconified == GLFW_TRUE);
 }
 
 void
-glfw_cursor_motion_callback(GLFWwindow* window, double x, double y)
+glfw_focus_callback(GLFWwindow* window, int focused)
 {
   App* app = (App*)glfwGetWindowUserPointer(window);
 
-  app->on_cursor_motion(x, y);
+  app->on_focus(focused == GLFW_TRUE);
+}
+
+void
+glfw_cursor_motion_callback(GLFWwindow* window, double x, double y)
+{
+  InputRecord record;
+  record.type = InputRecord::Type::cursor_motion;
+  record.x = x;
+  record.y = y;
+
+  handle_input(window, record);
 }
 
 void
@@ -50,9 +120,13 @@ glfw_cursor_button_callback(GLFWwindow* window,
                             int action,
                             int mods)
 {
-  App* app = (App*)glfwGetWindowUserPointer(window);
+  InputRecord record;
+  record.type = InputRecord::Type::cursor_button;
+  record.key = button;
+  record.action = action;
+  record.mods = mods;
 
-  app->on_cursor_button(button, action, mods);
+  handle_input(window, record);
 }
 
 void
@@ -65,16 +139,227 @@ glfw_key_callback(GLFWwindow* window,
   if ((key == GLFW_KEY_ESCAPE) && (action == GLFW_PRESS))
     glfwSetWindowShouldClose(window, GLFW_TRUE);
 
-  App* app = (App*)glfwGetWindowUserPointer(window);
+  InputRecord record;
+  record.type = InputRecord::Type::key;
+  record.key = key;
+  record.scancode = scancode;
+  record.action = action;
+  record.mods = mods;
+
+  handle_input(window, record);
+}
+
+int
+get_swap_interval(PresentMode present_mode)
+{
+  switch (present_mode) {
+    case PresentMode::vsync:
+      break;
+    case PresentMode::immediate:
+      return 0;
+    case PresentMode::adaptive:
+      // A negative interval means adaptive vsync, when either extension is there.
+      if (glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+        return -1;
+      break;
+  }
+
+  return 1;
+}
+
+/// Sleeps between frames so that they do not come faster than a given rate.
+class FramePacer final
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  FramePacer(float max_frame_rate)
+  {
+    if (max_frame_rate > 0)
+      m_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / max_frame_rate));
+  }
+
+  /// Sleeps until the next frame is due.
+  void wait()
+  {
+    if (m_period == Clock::duration::zero())
+      return;
+
+    const auto now = Clock::now();
+
+    // After a stall, such as while waiting for events, frames are paced from
+    // now on instead of being rushed to catch up.
+    if ((m_next_frame + m_period) < now)
+      m_next_frame = now;
+
+    std::this_thread::sleep_until(m_next_frame);
+
+    m_next_frame += m_period;
+  }
+
+private:
+  Clock::duration m_period = Clock::duration::zero();
+
+  Clock::time_point m_next_frame = Clock::now();
+};
+
+/// A window and the app that it shows.
+struct View final
+{
+  GLFWwindow* window = nullptr;
+
+  std::unique_ptr<App> app;
+
+  /// The number of frames drawn while the app had nothing to do.
+  int idle_frames = 0;
+};
+
+/// The window that ImGui is drawn over, since its GLFW backend only supports one.
+GLFWwindow* g_imgui_window = nullptr;
+
+void
+set_callbacks(GLFWwindow* window)
+{
+  glfwSetKeyCallback(window, glfw_key_callback);
+
+  glfwSetWindowSizeCallback(window, glfw_resize_callback);
+
+  glfwSetWindowIconifyCallback(window, glfw_iconify_callback);
+
+  glfwSetWindowFocusCallback(window, glfw_focus_callback);
+
+  glfwSetCursorPosCallback(window, glfw_cursor_motion_callback);
+
+  glfwSetMouseButtonCallback(window, glfw_cursor_button_callback);
+}
+
+void
+draw_frame(View& view)
+{
+  glfwMakeContextCurrent(view.window);
+
+  // Minimized windows and windows whose background policy does not present
+  // are not drawn or swapped, which could otherwise block on some drivers.
+  if (!view.app->is_presenting()) {
+    view.app->on_frame();
+    return;
+  }
+
+  int display_w = 0, display_h = 0;
+
+  glfwGetFramebufferSize(view.window, &display_w, &display_h);
+
+  glViewport(0, 0, display_w, display_h);
+
+  glClearColor(0, 0, 0, 1);
+
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+#ifndef WINDOWBLIT_DISABLE_IMGUI
+  const bool imgui = (view.window == g_imgui_window);
+
+  if (imgui) {
+
+    ImGui_ImplOpenGL3_NewFrame();
+
+    ImGui_ImplGlfw_NewFrame();
+
+    ImGui::NewFrame();
+  }
+#endif
+
+  view.app->on_frame();
+
+#ifndef WINDOWBLIT_DISABLE_IMGUI
+  if (imgui) {
+
+    ImGui::Render();
 
-  app->on_key(key, scancode, action, mods);
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  }
+#endif
+
+  glfwSwapBuffers(view.window);
+}
+
+/// Closes the app of a view, leaving the window to be destroyed by the caller.
+void
+close_app(View& view)
+{
+  glfwMakeContextCurrent(view.window);
+
+  view.app->on_close();
+
+  view.app.reset();
+
+  glfwSetWindowUserPointer(view.window, nullptr);
+}
+
+/// Feeds the input of the next recorded frame to the windows.
+///
+/// @return False once the recording is over.
+bool
+replay_frame(InputPlayer& player, std::vector<InputRecord>& records, std::vector<View>& views)
+{
+  if (!player.read_frame(records))
+    return false;
+
+  for (const InputRecord& record : records) {
+
+    set_replayed_input_time(record.time);
+
+    if (record.window >= int(g_windows.size()))
+      continue;
+
+    GLFWwindow* window = g_windows[record.window];
+
+    auto view = std::find_if(views.begin(), views.end(), [window](const View& v) { return v.window == window; });
+
+    // The window may have been closed by now.
+    if (view == views.end())
+      continue;
+
+    // The app gets the recorded size in the same frame, as it would without a window. Resizing the window is
+    // only for show, since the window manager may not give it that size or may only do so frames later.
+    if ((record.type == InputRecord::Type::resize) && (record.w > 0) && (record.h > 0))
+      glfwSetWindowSize(window, record.w, record.h);
+
+    dispatch_input(*view->app, record);
+  }
+
+  return true;
 }
 
 } // namespace
 
+GLFWwindow*
+get_imgui_window() noexcept
+{
+  return g_imgui_window;
+}
+
+int
+run_glfw_window(AppFactoryBase&& app_factory, const RunOptions& options)
+{
+  return run_glfw_windows({ &app_factory }, options);
+}
+
 int
-run_glfw_window(AppFactoryBase&& app_factory)
+run_glfw_windows(const std::vector<AppFactoryBase*>& app_factories, const RunOptions& options)
 {
+  if (app_factories.empty())
+    return EXIT_SUCCESS;
+
+  InputRecorder recorder;
+
+  if (options.record_path && !recorder.open(options.record_path))
+    return EXIT_FAILURE;
+
+  InputPlayer player;
+
+  if (options.replay_path && !player.open(options.replay_path))
+    return EXIT_FAILURE;
+
   if (glfwInit() != GLFW_TRUE) {
     std::cerr << "Failed to initialize GLFW" << std::endl;
     return EXIT_FAILURE;
@@ -82,27 +367,47 @@ run_glfw_window(AppFactoryBase&& app_factory)
 
   glfwSetErrorCallback(glfw_error_callback);
 
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, options.context_version_major);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, options.context_version_minor);
 
-  GLFWwindow* window = glfwCreateWindow(640, 480, "", nullptr, nullptr);
-  if (!window) {
-    std::cerr << "Failed to create main GLFW window" << std::endl;
-    glfwTerminate();
-    return EXIT_FAILURE;
-  }
+  std::vector<GLFWwindow*> windows;
+
+  for (std::size_t i = 0; i < app_factories.size(); i++) {
+
+    // The contexts all share the objects of the first one, so that data uploaded once can be drawn by every window.
+    GLFWwindow* shared_window = windows.empty() ? nullptr : windows[0];
 
-  glfwMakeContextCurrent(window);
+    GLFWwindow* window = glfwCreateWindow(options.width, options.height, options.title, nullptr, shared_window);
+    if (!window) {
 
-  glfwSwapInterval(1);
+      std::cerr << "Failed to create GLFW window" << std::endl;
+
+      for (GLFWwindow* created_window : windows)
+        glfwDestroyWindow(created_window);
+
+      glfwTerminate();
+
+      return EXIT_FAILURE;
+    }
+
+    windows.emplace_back(window);
+  }
+
+  glfwMakeContextCurrent(windows[0]);
 
   gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
 
-  int display_w = 0, display_h = 0;
+  for (std::size_t i = 0; i < windows.size(); i++) {
 
-  glfwGetFramebufferSize(window, &display_w, &display_h);
+    glfwMakeContextCurrent(windows[i]);
 
-  glViewport(0, 0, display_w, display_h);
+    // Only the first window waits for the vertical blank, otherwise each window would wait in turn.
+    glfwSwapInterval((i == 0) ? get_swap_interval(options.present_mode) : 0);
+  }
+
+  glfwMakeContextCurrent(windows[0]);
+
+  RenderThread::set_thread_count(options.render_thread_count);
 
 #ifndef WINDOWBLIT_DISABLE_IMGUI
   IMGUI_CHECKVERSION();
@@ -111,64 +416,152 @@ run_glfw_window(AppFactoryBase&& app_factory)
 
   ImGui::StyleColorsDark();
 
-  ImGui_ImplGlfw_InitForOpenGL(window, true);
+  ImGui_ImplGlfw_InitForOpenGL(windows[0], true);
 
   ImGui_ImplOpenGL3_Init("#version 120");
+
+  g_imgui_window = windows[0];
 #endif
   {
-    // Scoped so that the smart pointer is destroyed before GLFW window.
+    // Scoped so that the apps are destroyed before the GLFW windows.
 
-    std::unique_ptr<App> app(app_factory.create_app(window));
+    std::vector<View> views;
 
-    glfwSetWindowUserPointer(window, app.get());
+    for (std::size_t i = 0; i < windows.size(); i++) {
 
-    glfwSetKeyCallback(window, glfw_key_callback);
+      glfwMakeContextCurrent(windows[i]);
 
-    glfwSetWindowSizeCallback(window, glfw_resize_callback);
+      View view;
 
-    glfwSetCursorPosCallback(window, glfw_cursor_motion_callback);
+      view.window = windows[i];
 
-    glfwSetMouseButtonCallback(window, glfw_cursor_button_callback);
+      view.app.reset(app_factories[i]->create_app(windows[i]));
 
-    glfwMakeContextCurrent(window);
+      glfwSetWindowUserPointer(windows[i], view.app.get());
 
-    while (!glfwWindowShouldClose(window)) {
+      set_callbacks(windows[i]);
 
-      glClearColor(0, 0, 0, 1);
+      views.emplace_back(std::move(view));
+    }
 
-      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-      glClear(GL_COLOR_BUFFER_BIT);
+    g_windows = windows;
 
-      glfwPollEvents();
+    if (options.record_path) {
 
-#ifndef WINDOWBLIT_DISABLE_IMGUI
-      ImGui_ImplOpenGL3_NewFrame();
+      g_input_recorder = &recorder;
 
-      ImGui_ImplGlfw_NewFrame();
+      // The sizes that the windows start out with, which are otherwise never reported.
+      for (std::size_t i = 0; i < windows.size(); i++) {
+        InputRecord record;
+        record.type = InputRecord::Type::resize;
+        record.window = int(i);
+        record.time = glfwGetTime();
+        glfwGetWindowSize(windows[i], &record.w, &record.h);
+        recorder.write(record);
+      }
+    }
 
-      ImGui::NewFrame();
-#endif
+    g_input_replayed = (options.replay_path != nullptr);
 
-      app->on_frame();
+    std::vector<InputRecord> records;
 
-#ifndef WINDOWBLIT_DISABLE_IMGUI
-      ImGui::Render();
+    FrameStatistics statistics;
 
-      int display_w = 0, display_h = 0;
+    using Clock = std::chrono::steady_clock;
 
-      glfwGetFramebufferSize(window, &display_w, &display_h);
+    FramePacer frame_pacer(options.max_frame_rate);
 
-      glViewport(0, 0, display_w, display_h);
+    // Closing the first window closes all of them, since ImGui is drawn over it.
+    while (!glfwWindowShouldClose(views[0].window)) {
 
-      ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-#endif
+      const auto frame_start = Clock::now();
+
+      // Events are only waited for if every window can wait, and only for as long as the most impatient one can.
+      bool wait = true;
+
+      double timeout = std::numeric_limits<double>::infinity();
+
+      for (View& view : views) {
+
+        const double view_timeout = view.app->get_event_timeout();
+
+        // The frames after an event are only for ImGui, so they are skipped while minimized.
+        const bool view_waits = (view_timeout > 0) && ((view.idle_frames >= g_idle_frame_count) ||
+                                                       glfwGetWindowAttrib(view.window, GLFW_ICONIFIED));
+
+        wait = wait && view_waits;
+
+        timeout = std::min(timeout, view_timeout);
+
+        view.idle_frames = (view_timeout > 0) ? (view.idle_frames + 1) : 0;
+      }
+
+      // A replay has input for every frame, which would never arrive while waiting.
+      if (wait && !g_input_replayed) {
 
-      glfwMakeContextCurrent(window);
+        if (std::isinf(timeout))
+          glfwWaitEvents();
+        else
+          glfwWaitEventsTimeout(timeout);
 
-      glfwSwapBuffers(window);
+        for (View& view : views)
+          view.idle_frames = 0;
+
+      } else {
+        glfwPollEvents();
+      }
+
+      for (auto it = views.begin() + 1; it != views.end();) {
+
+        if (glfwWindowShouldClose(it->window)) {
+          close_app(*it);
+          glfwDestroyWindow(it->window);
+          it = views.erase(it);
+        } else {
+          ++it;
+        }
+      }
+
+      if (g_input_replayed && !replay_frame(player, records, views))
+        break;
+
+      if (g_input_recorder) {
+        InputRecord record;
+        record.type = InputRecord::Type::frame;
+        record.time = glfwGetTime();
+        g_input_recorder->write(record);
+      }
+
+      for (View& view : views)
+        draw_frame(view);
+
+      statistics.add(std::chrono::duration<double>(Clock::now() - frame_start).count());
+
+      frame_pacer.wait();
+    }
+
+    if (g_input_replayed) {
+
+      std::cout << "Replayed ";
+
+      statistics.print(std::cout);
+
+      std::cout << std::endl;
     }
 
-    app->on_close();
+    g_input_recorder = nullptr;
+
+    g_input_replayed = false;
+
+    set_replayed_input_time(-1);
+
+    for (auto it = views.rbegin(); it != views.rend(); ++it)
+      close_app(*it);
+
+    for (std::size_t i = 1; i < views.size(); i++)
+      glfwDestroyWindow(views[i].window);
+
+    glfwMakeContextCurrent(views[0].window);
   }
 
 #ifndef WINDOWBLIT_DISABLE_IMGUI
@@ -177,12 +570,19 @@ run_glfw_window(AppFactoryBase&& app_factory)
   ImGui_ImplGlfw_Shutdown();
 
   ImGui::DestroyContext();
+
+  g_imgui_window = nullptr;
 #endif
 
-  glfwDestroyWindow(window);
+  glfwDestroyWindow(windows[0]);
 
   glfwTerminate();
 
+  g_windows.clear();
+
+  if (options.record_path && !recorder.close())
+    return EXIT_FAILURE;
+
   return EXIT_SUCCESS;
 }
 
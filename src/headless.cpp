@@ -0,0 +1,366 @@
+#include <window_blit/headless.hpp>
+
+#include <window_blit/app_base.hpp>
+
+#include "egl_context.hpp"
+#include "frame_statistics.hpp"
+#include "input_recording.hpp"
+#include "readback_ring.hpp"
+
+#include "stb_image_write.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace window_blit {
+
+namespace {
+
+/// Creates the app of the factory, which must derive from @ref AppBase to run without a window.
+AppBase*
+create_app_base(AppFactoryBase& app_factory)
+{
+  std::unique_ptr<App> app(app_factory.create_app(nullptr));
+
+  auto* app_base = dynamic_cast<AppBase*>(app.get());
+
+  if (!app_base) {
+    std::cerr << "Only apps derived from AppBase can be run without a window" << std::endl;
+    return nullptr;
+  }
+
+  app.release();
+
+  return app_base;
+}
+
+bool
+has_replay(const HeadlessOptions& options)
+{
+  return options.replay_path && options.replay_path[0];
+}
+
+bool
+check_options(const HeadlessOptions& options)
+{
+  if ((options.width <= 0) || (options.height <= 0)) {
+    std::cerr << "Invalid headless resolution " << options.width << 'x' << options.height << std::endl;
+    return false;
+  }
+
+  if ((options.max_frame_count <= 0) && !options.stop_when_converged && !has_replay(options)) {
+    std::cerr << "Headless rendering would never stop, since there is no frame limit, no recording to replay and "
+                 "convergence is ignored"
+              << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+void
+print_statistics(const FrameStatistics& statistics, int w, int h, bool converged)
+{
+  if (!statistics.get_frame_count())
+    return;
+
+  std::cout << "Rendered ";
+
+  statistics.print(std::cout);
+
+  std::cout << " at " << w << 'x' << h << (converged ? ", converged" : "") << std::endl;
+}
+
+/// Feeds the input of the next recorded frame to an app rendered without a
+/// window. Only the input of the first window is replayed, and its resizes
+/// change the resolution.
+///
+/// @return False once the recording is over.
+bool
+replay_frame(InputPlayer& player, std::vector<InputRecord>& records, AppBase& app, int& w, int& h)
+{
+  if (!player.read_frame(records))
+    return false;
+
+  for (const InputRecord& record : records) {
+
+    if (record.window != 0)
+      continue;
+
+    set_replayed_input_time(record.time);
+
+    // Minimized windows are reported as having no size, in which case the last size is kept.
+    if ((record.type == InputRecord::Type::resize) && ((record.w <= 0) || (record.h <= 0)))
+      continue;
+
+    if (record.type == InputRecord::Type::resize) {
+      w = record.w;
+      h = record.h;
+    }
+
+    dispatch_input(app, record);
+  }
+
+  return true;
+}
+
+/// Writes the output image, if there is an output path.
+///
+/// @param rgba The pixels, with the top row first.
+bool
+write_image(const HeadlessOptions& options, const std::vector<unsigned char>& rgba, int w, int h)
+{
+  if (!options.output_path || !options.output_path[0])
+    return true;
+
+  if ((w <= 0) || (h <= 0)) {
+    std::cerr << "No image was rendered to write to '" << options.output_path << "'" << std::endl;
+    return false;
+  }
+
+  if (!stbi_write_png(options.output_path, w, h, 4, rgba.data(), w * 4)) {
+    std::cerr << "Failed to write '" << options.output_path << "'" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/// A framebuffer object with an 8-bit RGBA color buffer, bound for drawing and reading while it exists.
+class Framebuffer final
+{
+public:
+  Framebuffer(int w, int h)
+    : m_w(w)
+    , m_h(h)
+  {
+    glGenRenderbuffers(1, &m_color_buffer);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, m_color_buffer);
+
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+
+    glGenFramebuffers(1, &m_framebuffer);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color_buffer);
+
+    glViewport(0, 0, w, h);
+  }
+
+  Framebuffer(const Framebuffer&) = delete;
+
+  ~Framebuffer()
+  {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glDeleteFramebuffers(1, &m_framebuffer);
+
+    glDeleteRenderbuffers(1, &m_color_buffer);
+  }
+
+  bool is_complete() const { return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE; }
+
+  bool has_size(int w, int h) const noexcept { return (w == m_w) && (h == m_h); }
+
+private:
+  GLuint m_framebuffer = 0;
+
+  GLuint m_color_buffer = 0;
+
+  int m_w = 0;
+
+  int m_h = 0;
+};
+
+} // namespace
+
+int
+run_headless(AppFactoryBase&& app_factory, const HeadlessOptions& options)
+{
+  if (!check_options(options))
+    return EXIT_FAILURE;
+
+  InputPlayer player;
+
+  if (has_replay(options) && !player.open(options.replay_path))
+    return EXIT_FAILURE;
+
+  std::unique_ptr<AppBase> app(create_app_base(app_factory));
+
+  if (!app)
+    return EXIT_FAILURE;
+
+  using Clock = std::chrono::steady_clock;
+
+  using Seconds = std::chrono::duration<double>;
+
+  FrameStatistics statistics;
+
+  bool converged = false;
+
+  int w = options.width;
+  int h = options.height;
+
+  // Cursor motion is relative to the size of the window, which a window would have reported by now.
+  if (has_replay(options))
+    app->on_window_resize(w, h);
+
+  std::vector<InputRecord> records;
+
+  for (int i = 0; (options.max_frame_count <= 0) || (i < options.max_frame_count); i++) {
+
+    const auto frame_start = Clock::now();
+
+    if (has_replay(options) && !replay_frame(player, records, *app, w, h))
+      break;
+
+    converged = app->render_headless(w, h);
+
+    statistics.add(Seconds(Clock::now() - frame_start).count());
+
+    // A replay goes on until the recording ends, since later input may change the image again.
+    if (converged && options.stop_when_converged && !has_replay(options))
+      break;
+  }
+
+  set_replayed_input_time(-1);
+
+  app->on_close();
+
+  if (options.print_statistics)
+    print_statistics(statistics, w, h, converged);
+
+  std::vector<unsigned char> rgba;
+
+  int image_w = 0;
+  int image_h = 0;
+
+  app->get_headless_image(rgba, image_w, image_h);
+
+  return write_image(options, rgba, image_w, image_h) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int
+run_offscreen(AppFactoryBase&& app_factory, const HeadlessOptions& options)
+{
+  if (!check_options(options))
+    return EXIT_FAILURE;
+
+  InputPlayer player;
+
+  if (has_replay(options) && !player.open(options.replay_path))
+    return EXIT_FAILURE;
+
+  auto context = EglContext::create();
+
+  if (!context)
+    return EXIT_FAILURE;
+
+  if (!GLAD_GL_VERSION_3_0) {
+    std::cerr << "The offscreen context does not support framebuffer objects (OpenGL 3.0)" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The last image that was read back, with the top row first.
+  std::vector<unsigned char> rgba;
+
+  int image_w = 0;
+  int image_h = 0;
+
+  ReadbackRing readback([&rgba, &image_w, &image_h](const unsigned char* pixels, int pixels_w, int pixels_h) {
+    const std::size_t row_size = std::size_t(pixels_w) * 4;
+    rgba.resize(row_size * std::size_t(pixels_h));
+    for (int y = 0; y < pixels_h; y++)
+      std::memcpy(&rgba[std::size_t(pixels_h - 1 - y) * row_size], pixels + (std::size_t(y) * row_size), row_size);
+    image_w = pixels_w;
+    image_h = pixels_h;
+  });
+
+  int w = options.width;
+  int h = options.height;
+
+  std::unique_ptr<Framebuffer> framebuffer(new Framebuffer(w, h));
+
+  if (!framebuffer->is_complete()) {
+    std::cerr << "Failed to create an offscreen framebuffer of " << w << 'x' << h << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::unique_ptr<AppBase> app(create_app_base(app_factory));
+
+  if (!app)
+    return EXIT_FAILURE;
+
+  using Clock = std::chrono::steady_clock;
+
+  using Seconds = std::chrono::duration<double>;
+
+  FrameStatistics statistics;
+
+  bool converged = false;
+
+  // Cursor motion is relative to the size of the window, which a window would have reported by now.
+  if (has_replay(options))
+    app->on_window_resize(w, h);
+
+  std::vector<InputRecord> records;
+
+  bool failed = false;
+
+  for (int i = 0; (options.max_frame_count <= 0) || (i < options.max_frame_count); i++) {
+
+    const auto frame_start = Clock::now();
+
+    if (has_replay(options) && !replay_frame(player, records, *app, w, h))
+      break;
+
+    if (has_replay(options) && !framebuffer->has_size(w, h)) {
+
+      // The old framebuffer is released first, since it unbinds whatever framebuffer is bound.
+      framebuffer.reset();
+
+      framebuffer.reset(new Framebuffer(w, h));
+
+      if (!framebuffer->is_complete()) {
+        std::cerr << "Failed to resize the offscreen framebuffer to " << w << 'x' << h << std::endl;
+        failed = true;
+        break;
+      }
+    }
+
+    converged = app->render_headless(w, h);
+
+    readback.read(w, h);
+
+    statistics.add(Seconds(Clock::now() - frame_start).count());
+
+    // A replay goes on until the recording ends, since later input may change the image again.
+    if (converged && options.stop_when_converged && !has_replay(options))
+      break;
+  }
+
+  set_replayed_input_time(-1);
+
+  readback.finish();
+
+  app->on_close();
+
+  app.reset();
+
+  if (failed)
+    return EXIT_FAILURE;
+
+  if (options.print_statistics)
+    print_statistics(statistics, w, h, converged);
+
+  return write_image(options, rgba, image_w, image_h) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace window_blit
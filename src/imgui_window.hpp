@@ -0,0 +1,12 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+namespace window_blit {
+
+/// Gets the window that ImGui is drawn over by @ref run_glfw_windows, or null
+/// if ImGui was not set up by it.
+GLFWwindow*
+get_imgui_window() noexcept;
+
+} // namespace window_blit
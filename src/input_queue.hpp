@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+
+namespace window_blit {
+
+/// An input event, along with the time it was received.
+struct InputEvent final
+{
+  enum class Type
+  {
+    key,
+    cursor_motion
+  };
+
+  Type type = Type::key;
+
+  /// The time the event was received, in seconds, as returned by glfwGetTime.
+  double time = 0;
+
+  int key = 0;
+
+  int action = 0;
+
+  /// The cursor position, relative to the window size.
+  double x = 0;
+
+  double y = 0;
+
+  /// The cursor movement since the previous motion event.
+  double dx = 0;
+
+  double dy = 0;
+};
+
+/// Collects the input events of a frame, so that they can be handled all at
+/// once instead of as they arrive.
+///
+/// @details Events arrive through the GLFW callbacks, which are called on the
+/// window thread while polling for events, so no locking is needed.
+class InputQueue final
+{
+public:
+  void push(const InputEvent& event) { m_events.emplace_back(event); }
+
+  /// Moves the queued events into @p events, in the order they arrived.
+  /// Swapping the vectors keeps both of their allocations around for later frames.
+  void drain(std::vector<InputEvent>& events)
+  {
+    events.clear();
+
+    events.swap(m_events);
+  }
+
+private:
+  std::vector<InputEvent> m_events;
+};
+
+} // namespace window_blit
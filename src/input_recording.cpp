@@ -0,0 +1,343 @@
+#include "input_recording.hpp"
+
+#include <window_blit/app.hpp>
+
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <iostream>
+#include <iterator>
+
+#include <cstdint>
+#include <cstring>
+
+namespace window_blit {
+
+namespace {
+
+const unsigned char g_magic[4] = { 'W', 'B', 'I', 'R' };
+
+/// Changed whenever the layout of the records changes.
+const std::uint32_t g_version = 1;
+
+/// How many bytes of records are buffered before they are written out.
+const std::size_t g_flush_size = 64 * 1024;
+
+/// The recorded time being replayed, or a negative value outside of a replay.
+std::atomic<double> g_replayed_time{ -1.0 };
+
+void
+put_u8(std::vector<unsigned char>& buffer, int value)
+{
+  buffer.push_back(static_cast<unsigned char>(value));
+}
+
+void
+put_u32(std::vector<unsigned char>& buffer, std::uint32_t value)
+{
+  for (int i = 0; i < 4; i++)
+    buffer.push_back(static_cast<unsigned char>(value >> (i * 8)));
+}
+
+void
+put_f64(std::vector<unsigned char>& buffer, double value)
+{
+  std::uint64_t bits = 0;
+
+  std::memcpy(&bits, &value, sizeof(bits));
+
+  for (int i = 0; i < 8; i++)
+    buffer.push_back(static_cast<unsigned char>(bits >> (i * 8)));
+}
+
+/// Decodes the values of a record, failing once the data runs out.
+class RecordReader final
+{
+public:
+  RecordReader(const std::vector<unsigned char>& data, std::size_t offset)
+    : m_data(data)
+    , m_offset(offset)
+  {}
+
+  bool good() const noexcept { return m_good; }
+
+  std::size_t get_offset() const noexcept { return m_offset; }
+
+  int get_u8() { return read(1) ? m_data[m_offset - 1] : 0; }
+
+  std::uint32_t get_u32()
+  {
+    if (!read(4))
+      return 0;
+
+    std::uint32_t value = 0;
+
+    for (int i = 0; i < 4; i++)
+      value |= std::uint32_t(m_data[m_offset - 4 + i]) << (i * 8);
+
+    return value;
+  }
+
+  double get_f64()
+  {
+    if (!read(8))
+      return 0;
+
+    std::uint64_t bits = 0;
+
+    for (int i = 0; i < 8; i++)
+      bits |= std::uint64_t(m_data[m_offset - 8 + i]) << (i * 8);
+
+    double value = 0;
+
+    std::memcpy(&value, &bits, sizeof(value));
+
+    return value;
+  }
+
+private:
+  /// Consumes a number of bytes, if there are that many left.
+  bool read(std::size_t size)
+  {
+    m_good = m_good && ((m_data.size() - m_offset) >= size);
+
+    if (m_good)
+      m_offset += size;
+
+    return m_good;
+  }
+
+private:
+  const std::vector<unsigned char>& m_data;
+
+  std::size_t m_offset = 0;
+
+  bool m_good = true;
+};
+
+} // namespace
+
+bool
+InputRecorder::open(const char* path)
+{
+  m_path = path;
+
+  m_file.open(path, std::ios::binary | std::ios::trunc);
+
+  if (!m_file.good()) {
+    std::cerr << "Failed to create the input recording '" << path << "'" << std::endl;
+    return false;
+  }
+
+  m_buffer.assign(std::begin(g_magic), std::end(g_magic));
+
+  put_u32(m_buffer, g_version);
+
+  return true;
+}
+
+void
+InputRecorder::write(const InputRecord& record)
+{
+  put_u8(m_buffer, int(record.type));
+
+  put_u8(m_buffer, record.window);
+
+  put_f64(m_buffer, record.time);
+
+  switch (record.type) {
+    case InputRecord::Type::frame:
+      break;
+    case InputRecord::Type::key:
+      put_u32(m_buffer, std::uint32_t(record.key));
+      put_u32(m_buffer, std::uint32_t(record.scancode));
+      put_u8(m_buffer, record.action);
+      put_u8(m_buffer, record.mods);
+      break;
+    case InputRecord::Type::cursor_button:
+      put_u8(m_buffer, record.key);
+      put_u8(m_buffer, record.action);
+      put_u8(m_buffer, record.mods);
+      break;
+    case InputRecord::Type::cursor_motion:
+      put_f64(m_buffer, record.x);
+      put_f64(m_buffer, record.y);
+      break;
+    case InputRecord::Type::resize:
+      put_u32(m_buffer, std::uint32_t(record.w));
+      put_u32(m_buffer, std::uint32_t(record.h));
+      break;
+  }
+
+  if (m_buffer.size() >= g_flush_size)
+    flush();
+}
+
+bool
+InputRecorder::close()
+{
+  flush();
+
+  m_file.close();
+
+  if (m_file.fail()) {
+    std::cerr << "Failed to write the input recording '" << m_path << "'" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+void
+InputRecorder::flush()
+{
+  m_file.write(reinterpret_cast<const char*>(m_buffer.data()), std::streamsize(m_buffer.size()));
+
+  m_buffer.clear();
+}
+
+bool
+InputPlayer::open(const char* path)
+{
+  m_path = path;
+
+  std::ifstream file(path, std::ios::binary);
+
+  if (!file.good()) {
+    std::cerr << "Failed to open the input recording '" << path << "'" << std::endl;
+    return false;
+  }
+
+  // Recordings are small enough to be read all at once, which keeps the disk out of the frame times.
+  m_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+  RecordReader reader(m_data, sizeof(g_magic));
+
+  const std::uint32_t version = reader.get_u32();
+
+  if (!reader.good() || (std::memcmp(m_data.data(), g_magic, sizeof(g_magic)) != 0)) {
+    std::cerr << "'" << path << "' is not an input recording" << std::endl;
+    return false;
+  }
+
+  if (version != g_version) {
+    std::cerr << "'" << path << "' is an input recording of version " << version << ", but only version "
+              << g_version << " is supported" << std::endl;
+    return false;
+  }
+
+  m_offset = reader.get_offset();
+
+  return true;
+}
+
+bool
+InputPlayer::read_frame(std::vector<InputRecord>& records)
+{
+  records.clear();
+
+  while (m_offset < m_data.size()) {
+
+    RecordReader reader(m_data, m_offset);
+
+    InputRecord record;
+
+    const int type = reader.get_u8();
+
+    record.window = reader.get_u8();
+
+    record.time = reader.get_f64();
+
+    switch (type) {
+      case int(InputRecord::Type::frame):
+        record.type = InputRecord::Type::frame;
+        break;
+      case int(InputRecord::Type::key):
+        record.type = InputRecord::Type::key;
+        record.key = int(reader.get_u32());
+        record.scancode = int(reader.get_u32());
+        record.action = reader.get_u8();
+        record.mods = reader.get_u8();
+        break;
+      case int(InputRecord::Type::cursor_button):
+        record.type = InputRecord::Type::cursor_button;
+        record.key = reader.get_u8();
+        record.action = reader.get_u8();
+        record.mods = reader.get_u8();
+        break;
+      case int(InputRecord::Type::cursor_motion):
+        record.type = InputRecord::Type::cursor_motion;
+        record.x = reader.get_f64();
+        record.y = reader.get_f64();
+        break;
+      case int(InputRecord::Type::resize):
+        record.type = InputRecord::Type::resize;
+        record.w = int(reader.get_u32());
+        record.h = int(reader.get_u32());
+        break;
+      default:
+        std::cerr << "Unknown record type " << type << " in the input recording '" << m_path << "'" << std::endl;
+        m_offset = m_data.size();
+        return false;
+    }
+
+    if (!reader.good()) {
+      std::cerr << "The input recording '" << m_path << "' ends in the middle of a record" << std::endl;
+      m_offset = m_data.size();
+      return false;
+    }
+
+    m_offset = reader.get_offset();
+
+    records.emplace_back(record);
+
+    if (record.type == InputRecord::Type::frame)
+      return true;
+  }
+
+  // Events after the last frame were never handled, so they are not replayed either.
+  return false;
+}
+
+void
+dispatch_input(App& app, const InputRecord& record)
+{
+  switch (record.type) {
+    case InputRecord::Type::frame:
+      break;
+    case InputRecord::Type::key:
+      app.on_key(record.key, record.scancode, record.action, record.mods);
+      break;
+    case InputRecord::Type::cursor_button:
+      app.on_cursor_button(record.key, record.action, record.mods);
+      break;
+    case InputRecord::Type::cursor_motion:
+      app.on_cursor_motion(record.x, record.y);
+      break;
+    case InputRecord::Type::resize:
+      app.on_window_resize(record.w, record.h);
+      break;
+  }
+}
+
+double
+get_input_time()
+{
+  const double replayed_time = g_replayed_time;
+
+  return (replayed_time >= 0) ? replayed_time : glfwGetTime();
+}
+
+void
+set_replayed_input_time(double time)
+{
+  g_replayed_time = time;
+}
+
+bool
+is_input_replayed()
+{
+  return g_replayed_time >= 0;
+}
+
+} // namespace window_blit
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <fstream>
+#include <vector>
+
+#include <cstddef>
+
+namespace window_blit {
+
+class App;
+
+/// An input event that a window received, or the start of a frame, as stored
+/// in an input recording.
+struct InputRecord final
+{
+  enum class Type
+  {
+    /// A frame was drawn, after the events before it were handled.
+    frame,
+    key,
+    cursor_button,
+    cursor_motion,
+    resize
+  };
+
+  Type type = Type::frame;
+
+  /// The index of the window that received the event, in the order that the windows were created.
+  int window = 0;
+
+  /// The time of the event, in seconds, as returned by glfwGetTime.
+  double time = 0;
+
+  /// The key, or the cursor button.
+  int key = 0;
+
+  int scancode = 0;
+
+  int action = 0;
+
+  int mods = 0;
+
+  /// The cursor position, in screen coordinates.
+  double x = 0;
+
+  double y = 0;
+
+  /// The size of the window, in screen coordinates.
+  int w = 0;
+
+  int h = 0;
+};
+
+/// Writes input records to a compact binary file, which is read back by @ref InputPlayer.
+///
+/// @details The file starts with a magic number and a version, followed by
+/// the records. Each record is a byte for the type and one for the window,
+/// the time as a double and then only the fields that the type uses. All of
+/// the values are little endian.
+class InputRecorder final
+{
+public:
+  /// @return False, after printing the reason, if the file could not be created.
+  bool open(const char* path);
+
+  void write(const InputRecord& record);
+
+  /// Writes out the records that are still buffered.
+  ///
+  /// @return False, after printing the reason, if the file could not be written.
+  bool close();
+
+private:
+  void flush();
+
+private:
+  std::ofstream m_file;
+
+  /// The records that were encoded but not written yet.
+  std::vector<unsigned char> m_buffer;
+
+  const char* m_path = "";
+};
+
+/// Reads back the input records written by @ref InputRecorder, a frame at a time.
+class InputPlayer final
+{
+public:
+  /// @return False, after printing the reason, if the file could not be read
+  /// or is not an input recording.
+  bool open(const char* path);
+
+  /// Gets the records of the next frame, which are the events that arrived
+  /// before it followed by the frame record itself.
+  ///
+  /// @return False once there are no frames left, or if the rest of the recording is malformed.
+  bool read_frame(std::vector<InputRecord>& records);
+
+private:
+  std::vector<unsigned char> m_data;
+
+  std::size_t m_offset = 0;
+
+  const char* m_path = "";
+};
+
+/// Calls the function of the app that handles a key, cursor button, cursor
+/// motion or resize event. Frame records are ignored.
+void
+dispatch_input(App& app, const InputRecord& record);
+
+/// Gets the time that input events are stamped with and that the camera
+/// moves by, in seconds.
+///
+/// @details This is the time returned by glfwGetTime, except while a
+/// recording is replayed, in which case it is the recorded time of the event
+/// or frame being replayed. That way, the camera moves by the same amount on
+/// each replay, no matter how long the frames take.
+double
+get_input_time();
+
+/// Sets the time returned by @ref get_input_time while replaying. A negative
+/// time ends the replay, going back to the time of GLFW.
+void
+set_replayed_input_time(double time);
+
+/// Indicates whether a recording is being replayed, as set by @ref set_replayed_input_time.
+bool
+is_input_replayed();
+
+} // namespace window_blit
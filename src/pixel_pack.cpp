@@ -0,0 +1,312 @@
+#include "pixel_pack.hpp"
+
+#include <algorithm>
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define WINDOWBLIT_PACK_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(WINDOWBLIT_PACK_SSE2) && defined(__F16C__)
+#define WINDOWBLIT_PACK_F16C 1
+#include <immintrin.h>
+#endif
+
+namespace window_blit {
+
+namespace {
+
+/// The largest value that can be represented by GL_RGB9_E5.
+const float g_rgb9_e5_max = 65408.0f;
+
+std::uint32_t
+float_bits(float value)
+{
+  std::uint32_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+float
+bits_float(std::uint32_t bits)
+{
+  float value = 0;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/// Based on the branchy round-to-nearest-even conversion described by Fabian
+/// Giesen. The SSE2 version below is the same algorithm with the branches
+/// replaced by masks.
+std::uint16_t
+to_half(float value)
+{
+  std::uint32_t u = float_bits(value);
+
+  const std::uint32_t sign = u & 0x80000000u;
+
+  u ^= sign;
+
+  std::uint32_t out = 0;
+
+  if (u >= (143u << 23)) {
+    // Inf or NaN (NaN stays quiet)
+    out = (u > (255u << 23)) ? 0x7e00 : 0x7c00;
+  } else if (u < (113u << 23)) {
+    // Subnormal or zero. Adding 0.5 aligns the mantissa bits at the bottom,
+    // with the FPU doing the rounding.
+    out = float_bits(bits_float(u) + 0.5f) - (126u << 23);
+  } else {
+    const std::uint32_t mant_odd = (u >> 13) & 1;
+    out = (u - (112u << 23) + 0xfff + mant_odd) >> 13;
+  }
+
+  return std::uint16_t(out | (sign >> 16));
+}
+
+float
+clamp_rgb9_e5(float value)
+{
+  // Written so that NaN becomes zero.
+  return (value > 0.0f) ? std::min(value, g_rgb9_e5_max) : 0.0f;
+}
+
+std::uint32_t
+to_rgb9_e5(float r, float g, float b)
+{
+  r = clamp_rgb9_e5(r);
+  g = clamp_rgb9_e5(g);
+  b = clamp_rgb9_e5(b);
+
+  const float max_rgb = std::max(r, std::max(g, b));
+
+  // Zero and denormals have a biased exponent of zero, which this clamps to the
+  // smallest shared exponent.
+  const int exponent = int(float_bits(max_rgb) >> 23) - 127;
+
+  std::uint32_t shared = std::uint32_t(std::max(exponent, -16) + 16);
+
+  // 2 ^ (9 + 15 - shared), the reciprocal of the mantissa step
+  float scale = bits_float((151u - shared) << 23);
+
+  if (std::uint32_t(max_rgb * scale + 0.5f) == 512) {
+    shared++;
+    scale *= 0.5f;
+  }
+
+  const std::uint32_t rm = std::uint32_t(r * scale + 0.5f);
+  const std::uint32_t gm = std::uint32_t(g * scale + 0.5f);
+  const std::uint32_t bm = std::uint32_t(b * scale + 0.5f);
+
+  return rm | (gm << 9) | (bm << 18) | (shared << 27);
+}
+
+#ifdef WINDOWBLIT_PACK_SSE2
+
+__m128i
+select_si128(__m128i mask, __m128i a, __m128i b)
+{
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+#ifndef WINDOWBLIT_PACK_F16C
+
+__m128i
+to_half_sse2(__m128 value)
+{
+  __m128i u = _mm_castps_si128(value);
+
+  const __m128i sign = _mm_and_si128(u, _mm_set1_epi32(int(0x80000000u)));
+
+  u = _mm_xor_si128(u, sign);
+
+  // Since the sign bit is clear, signed comparisons work here.
+  const __m128i is_large = _mm_cmpgt_epi32(u, _mm_set1_epi32((143 << 23) - 1));
+  const __m128i is_nan = _mm_cmpgt_epi32(u, _mm_set1_epi32(255 << 23));
+  const __m128i is_small = _mm_cmplt_epi32(u, _mm_set1_epi32(113 << 23));
+
+  const __m128i large = select_si128(is_nan, _mm_set1_epi32(0x7e00), _mm_set1_epi32(0x7c00));
+
+  const __m128 small_f = _mm_add_ps(_mm_castsi128_ps(u), _mm_set1_ps(0.5f));
+  const __m128i small = _mm_sub_epi32(_mm_castps_si128(small_f), _mm_set1_epi32(126 << 23));
+
+  const __m128i mant_odd = _mm_and_si128(_mm_srli_epi32(u, 13), _mm_set1_epi32(1));
+  __m128i normal = _mm_sub_epi32(u, _mm_set1_epi32((112 << 23) - 0xfff));
+  normal = _mm_srli_epi32(_mm_add_epi32(normal, mant_odd), 13);
+
+  const __m128i out = select_si128(is_large, large, select_si128(is_small, small, normal));
+
+  return _mm_or_si128(out, _mm_srli_epi32(sign, 16));
+}
+
+/// Narrows 32-bit lanes holding 16-bit values. The lanes are sign extended first
+/// so that the saturating pack leaves them untouched.
+__m128i
+narrow_epi32(__m128i a, __m128i b)
+{
+  a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+  b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+  return _mm_packs_epi32(a, b);
+}
+
+#endif // WINDOWBLIT_PACK_F16C
+
+__m128
+clamp_rgb9_e5_sse2(__m128 value)
+{
+  // The operand order makes NaN become zero.
+  return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(g_rgb9_e5_max));
+}
+
+__m128i
+to_rgb9_e5_sse2(__m128 r, __m128 g, __m128 b)
+{
+  r = clamp_rgb9_e5_sse2(r);
+  g = clamp_rgb9_e5_sse2(g);
+  b = clamp_rgb9_e5_sse2(b);
+
+  const __m128 max_rgb = _mm_max_ps(r, _mm_max_ps(g, b));
+
+  __m128i exponent = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(max_rgb), 23), _mm_set1_epi32(127));
+
+  exponent = select_si128(_mm_cmpgt_epi32(exponent, _mm_set1_epi32(-16)), exponent, _mm_set1_epi32(-16));
+
+  __m128i shared = _mm_add_epi32(exponent, _mm_set1_epi32(16));
+
+  __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(151), shared), 23));
+
+  const __m128 half = _mm_set1_ps(0.5f);
+
+  const __m128i max_m = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(max_rgb, scale), half));
+
+  const __m128i overflow = _mm_cmpeq_epi32(max_m, _mm_set1_epi32(512));
+
+  // The mask is all ones (minus one) where the mantissa overflowed.
+  shared = _mm_sub_epi32(shared, overflow);
+
+  scale = _mm_mul_ps(scale, _mm_castsi128_ps(select_si128(overflow, _mm_castps_si128(half), _mm_castps_si128(_mm_set1_ps(1.0f)))));
+
+  const __m128i rm = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(r, scale), half));
+  const __m128i gm = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(g, scale), half));
+  const __m128i bm = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(b, scale), half));
+
+  __m128i out = rm;
+  out = _mm_or_si128(out, _mm_slli_epi32(gm, 9));
+  out = _mm_or_si128(out, _mm_slli_epi32(bm, 18));
+  out = _mm_or_si128(out, _mm_slli_epi32(shared, 27));
+  return out;
+}
+
+#endif // WINDOWBLIT_PACK_SSE2
+
+} // namespace
+
+void
+pack_half(const float* src, std::uint16_t* dst, std::size_t count, float scale)
+{
+  std::size_t i = 0;
+
+#if defined(WINDOWBLIT_PACK_F16C)
+
+  const __m128 s = _mm_set1_ps(scale);
+
+  for (; (i + 8) <= count; i += 8) {
+    const __m128i lo = _mm_cvtps_ph(_mm_mul_ps(_mm_loadu_ps(src + i), s), _MM_FROUND_TO_NEAREST_INT);
+    const __m128i hi = _mm_cvtps_ph(_mm_mul_ps(_mm_loadu_ps(src + i + 4), s), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi64(lo, hi));
+  }
+
+#elif defined(WINDOWBLIT_PACK_SSE2)
+
+  const __m128 s = _mm_set1_ps(scale);
+
+  for (; (i + 8) <= count; i += 8) {
+    const __m128i lo = to_half_sse2(_mm_mul_ps(_mm_loadu_ps(src + i), s));
+    const __m128i hi = to_half_sse2(_mm_mul_ps(_mm_loadu_ps(src + i + 4), s));
+    _mm_storeu_si128((__m128i*)(dst + i), narrow_epi32(lo, hi));
+  }
+
+#endif
+
+  for (; i < count; i++)
+    dst[i] = to_half(src[i] * scale);
+}
+
+void
+pack_half_rgba(const float* rgb, std::uint16_t* dst, std::size_t pixel_count, float scale)
+{
+  // Padded in chunks on the stack, so that the vectorized conversion can be used.
+  const std::size_t chunk_size = 256;
+
+  float rgba[chunk_size * 4];
+
+  for (std::size_t i = 0; i < pixel_count; i += chunk_size) {
+
+    const std::size_t count = std::min(chunk_size, pixel_count - i);
+
+    pad_rgba(rgb + (i * 3), rgba, count);
+
+    pack_half(rgba, dst + (i * 4), count * 4, scale);
+  }
+}
+
+void
+pad_rgba(const float* rgb, float* rgba, std::size_t pixel_count)
+{
+  for (std::size_t i = 0; i < pixel_count; i++) {
+    rgba[(i * 4) + 0] = rgb[(i * 3) + 0];
+    rgba[(i * 4) + 1] = rgb[(i * 3) + 1];
+    rgba[(i * 4) + 2] = rgb[(i * 3) + 2];
+    rgba[(i * 4) + 3] = 1.0f;
+  }
+}
+
+void
+pad_rgba(const std::uint8_t* rgb, std::uint8_t* rgba, std::size_t pixel_count, bool bgra)
+{
+  const std::size_t r = bgra ? 2 : 0;
+  const std::size_t b = bgra ? 0 : 2;
+
+  for (std::size_t i = 0; i < pixel_count; i++) {
+    rgba[(i * 4) + r] = rgb[(i * 3) + 0];
+    rgba[(i * 4) + 1] = rgb[(i * 3) + 1];
+    rgba[(i * 4) + b] = rgb[(i * 3) + 2];
+    rgba[(i * 4) + 3] = 255;
+  }
+}
+
+void
+pack_rgb9_e5(const float* rgb, std::uint32_t* dst, std::size_t pixel_count, float scale, int channel_count)
+{
+  const std::size_t stride = std::size_t(channel_count);
+
+  std::size_t i = 0;
+
+#ifdef WINDOWBLIT_PACK_SSE2
+
+  const __m128 s = _mm_set1_ps(scale);
+
+  for (; (i + 4) <= pixel_count; i += 4) {
+
+    const float* p = rgb + (i * stride);
+
+    const __m128 r = _mm_mul_ps(_mm_setr_ps(p[0], p[stride], p[stride * 2], p[stride * 3]), s);
+    const __m128 g = _mm_mul_ps(_mm_setr_ps(p[1], p[stride + 1], p[(stride * 2) + 1], p[(stride * 3) + 1]), s);
+    const __m128 b = _mm_mul_ps(_mm_setr_ps(p[2], p[stride + 2], p[(stride * 2) + 2], p[(stride * 3) + 2]), s);
+
+    _mm_storeu_si128((__m128i*)(dst + i), to_rgb9_e5_sse2(r, g, b));
+  }
+
+#endif
+
+  for (; i < pixel_count; i++) {
+
+    const float* p = rgb + (i * stride);
+
+    dst[i] = to_rgb9_e5(p[0] * scale, p[1] * scale, p[2] * scale);
+  }
+}
+
+} // namespace window_blit
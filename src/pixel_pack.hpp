@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace window_blit {
+
+/// Converts floats to IEEE 754 half precision floats, rounding to the nearest
+/// even value. Values too large for a half float become infinity.
+///
+/// @param scale Each value is multiplied by this before the conversion.
+void
+pack_half(const float* src, std::uint16_t* dst, std::size_t count, float scale = 1.0f);
+
+/// Converts RGB pixels to the shared exponent format used by GL_RGB9_E5, as
+/// laid out by GL_UNSIGNED_INT_5_9_9_9_REV. Negative values become zero and
+/// values too large for the format are clamped.
+///
+/// @param scale Each channel is multiplied by this before the conversion.
+///
+/// @param channel_count The number of floats per source pixel, which is four
+/// for RGBA pixels. Only the first three are used.
+void
+pack_rgb9_e5(const float* rgb, std::uint32_t* dst, std::size_t pixel_count, float scale = 1.0f, int channel_count = 3);
+
+/// Converts RGB pixels to half precision RGBA pixels. The alpha channel is
+/// unused and set to @p scale.
+void
+pack_half_rgba(const float* rgb, std::uint16_t* dst, std::size_t pixel_count, float scale = 1.0f);
+
+/// Pads RGB pixels to RGBA pixels, with an alpha of one.
+void
+pad_rgba(const float* rgb, float* rgba, std::size_t pixel_count);
+
+/// Pads RGB pixels to RGBA pixels, with an alpha of 255.
+///
+/// @param bgra Whether to swap the red and blue channels.
+void
+pad_rgba(const std::uint8_t* rgb, std::uint8_t* rgba, std::size_t pixel_count, bool bgra = false);
+
+} // namespace window_blit
@@ -0,0 +1,192 @@
+#include "pixel_transfer.hpp"
+
+#include "pixel_pack.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace window_blit {
+
+PixelTransfer
+make_rgb_transfer(const float* rgb, int w, int h, UploadFormat format, const DisplayTransform& display)
+{
+  const std::size_t pixel_count = std::size_t(w) * std::size_t(h);
+
+  // The sample weight is applied while packing, so that accumulated values
+  // stay in the range of the smaller formats.
+  const float scale = (display.sample_weight > 0) ? display.sample_weight : 1.0f;
+
+  PixelTransfer transfer;
+
+  transfer.internal_format = get_internal_format(format);
+
+  switch (format) {
+    case UploadFormat::rgb32f:
+    case UploadFormat::automatic:
+      transfer.size = pixel_count * sizeof(float) * 3;
+      transfer.fill = [rgb, pixel_count](void* dst) { std::memcpy(dst, rgb, pixel_count * sizeof(float) * 3); };
+      break;
+    case UploadFormat::rgba32f:
+      transfer.format = GL_RGBA;
+      transfer.size = pixel_count * sizeof(float) * 4;
+      transfer.fill = [rgb, pixel_count](void* dst) { pad_rgba(rgb, static_cast<float*>(dst), pixel_count); };
+      break;
+    case UploadFormat::rgb16f:
+      transfer.type = GL_HALF_FLOAT;
+      transfer.size = pixel_count * 6;
+      transfer.sample_weight = scale;
+      transfer.fill = [rgb, pixel_count, scale](void* dst) {
+        pack_half(rgb, static_cast<std::uint16_t*>(dst), pixel_count * 3, scale);
+      };
+      break;
+    case UploadFormat::rgba16f:
+      transfer.format = GL_RGBA;
+      transfer.type = GL_HALF_FLOAT;
+      transfer.size = pixel_count * 8;
+      transfer.sample_weight = scale;
+      transfer.fill = [rgb, pixel_count, scale](void* dst) {
+        pack_half_rgba(rgb, static_cast<std::uint16_t*>(dst), pixel_count, scale);
+      };
+      break;
+    case UploadFormat::rgb9_e5:
+      transfer.type = GL_UNSIGNED_INT_5_9_9_9_REV;
+      transfer.size = pixel_count * 4;
+      transfer.sample_weight = scale;
+      transfer.fill = [rgb, pixel_count, scale](void* dst) {
+        pack_rgb9_e5(rgb, static_cast<std::uint32_t*>(dst), pixel_count, scale);
+      };
+      break;
+    case UploadFormat::display_rgba8:
+      transfer.format = GL_RGBA;
+      transfer.type = GL_UNSIGNED_BYTE;
+      transfer.size = pixel_count * 4;
+      transfer.sample_weight = scale;
+      transfer.display_encoded = true;
+      transfer.fill = [rgb, pixel_count, display](void* dst) {
+        encode_display_rgba8(rgb, static_cast<std::uint8_t*>(dst), pixel_count, display);
+      };
+      break;
+  }
+
+  return transfer;
+}
+
+PixelTransfer
+make_rgba_transfer(const float* rgba, int w, int h, UploadFormat format, const DisplayTransform& display)
+{
+  const std::size_t pixel_count = std::size_t(w) * std::size_t(h);
+
+  const float scale = (display.sample_weight > 0) ? display.sample_weight : 1.0f;
+
+  PixelTransfer transfer;
+
+  transfer.format = GL_RGBA;
+
+  switch (format) {
+    case UploadFormat::rgb32f:
+    case UploadFormat::rgba32f:
+    case UploadFormat::automatic:
+      transfer.internal_format = GL_RGBA32F;
+      transfer.size = pixel_count * sizeof(float) * 4;
+      transfer.fill = [rgba, pixel_count](void* dst) { std::memcpy(dst, rgba, pixel_count * sizeof(float) * 4); };
+      break;
+    case UploadFormat::rgb16f:
+    case UploadFormat::rgba16f:
+      transfer.internal_format = GL_RGBA16F;
+      transfer.type = GL_HALF_FLOAT;
+      transfer.size = pixel_count * 8;
+      transfer.sample_weight = scale;
+      transfer.fill = [rgba, pixel_count, scale](void* dst) {
+        pack_half(rgba, static_cast<std::uint16_t*>(dst), pixel_count * 4, scale);
+      };
+      break;
+    case UploadFormat::rgb9_e5:
+      transfer.internal_format = GL_RGB9_E5;
+      transfer.format = GL_RGB;
+      transfer.type = GL_UNSIGNED_INT_5_9_9_9_REV;
+      transfer.size = pixel_count * 4;
+      transfer.sample_weight = scale;
+      transfer.fill = [rgba, pixel_count, scale](void* dst) {
+        pack_rgb9_e5(rgba, static_cast<std::uint32_t*>(dst), pixel_count, scale, 4);
+      };
+      break;
+    case UploadFormat::display_rgba8:
+      transfer.internal_format = GL_RGBA8;
+      transfer.type = GL_UNSIGNED_BYTE;
+      transfer.size = pixel_count * 4;
+      transfer.sample_weight = scale;
+      transfer.display_encoded = true;
+      transfer.fill = [rgba, pixel_count, display](void* dst) {
+        encode_display_rgba8(rgba, static_cast<std::uint8_t*>(dst), pixel_count, display, 4);
+      };
+      break;
+  }
+
+  return transfer;
+}
+
+PixelTransfer
+make_rgb_transfer(const unsigned char* rgb, int w, int h, ByteLayout layout)
+{
+  const std::size_t pixel_count = std::size_t(w) * std::size_t(h);
+
+  PixelTransfer transfer;
+  transfer.internal_format = get_internal_format(layout);
+  transfer.type = GL_UNSIGNED_BYTE;
+
+  switch (layout) {
+    case ByteLayout::rgb:
+      transfer.size = pixel_count * 3;
+      transfer.fill = [rgb, pixel_count](void* dst) { std::memcpy(dst, rgb, pixel_count * 3); };
+      break;
+    case ByteLayout::rgba:
+      transfer.format = GL_RGBA;
+      transfer.size = pixel_count * 4;
+      transfer.fill = [rgb, pixel_count](void* dst) {
+        pad_rgba(rgb, static_cast<std::uint8_t*>(dst), pixel_count);
+      };
+      break;
+    case ByteLayout::bgra:
+      // With this type, the bytes are in BGRA order on little endian machines
+      // and the driver can usually copy them without swizzling.
+      transfer.format = GL_BGRA;
+      transfer.type = GL_UNSIGNED_INT_8_8_8_8_REV;
+      transfer.size = pixel_count * 4;
+      transfer.fill = [rgb, pixel_count](void* dst) {
+        pad_rgba(rgb, static_cast<std::uint8_t*>(dst), pixel_count, true);
+      };
+      break;
+  }
+
+  return transfer;
+}
+
+GLenum
+get_internal_format(UploadFormat format) noexcept
+{
+  switch (format) {
+    case UploadFormat::rgb32f:
+    case UploadFormat::automatic:
+      break;
+    case UploadFormat::rgba32f:
+      return GL_RGBA32F;
+    case UploadFormat::rgb16f:
+      return GL_RGB16F;
+    case UploadFormat::rgba16f:
+      return GL_RGBA16F;
+    case UploadFormat::rgb9_e5:
+      return GL_RGB9_E5;
+    case UploadFormat::display_rgba8:
+      return GL_RGBA8;
+  }
+
+  return GL_RGB32F;
+}
+
+GLenum
+get_internal_format(ByteLayout layout) noexcept
+{
+  return (layout == ByteLayout::rgb) ? GL_RGB8 : GL_RGBA8;
+}
+
+} // namespace window_blit
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <window_blit/app_base.hpp>
+#include <window_blit/display_transform.hpp>
+
+#include "upload_ring.hpp"
+
+#include <cstddef>
+
+namespace window_blit {
+
+/// Describes how an image is converted and transferred into a texture.
+struct PixelTransfer final
+{
+  GLenum internal_format = GL_RGB32F;
+
+  GLenum format = GL_RGB;
+
+  GLenum type = GL_FLOAT;
+
+  /// The number of bytes written by @ref fill.
+  std::size_t size = 0;
+
+  /// The sample weight that @ref fill applies to the pixels.
+  float sample_weight = 1;
+
+  /// Whether @ref fill applies the whole display transform, in which case the
+  /// shader must not apply it again.
+  bool display_encoded = false;
+
+  /// Writes the pixels in the transfer format.
+  UploadRing::FillFunction fill;
+};
+
+/// Describes the transfer of a floating point RGB image in the given format.
+///
+/// @param display The sample weight is applied to the pixels by the formats
+/// that can't hold large accumulated values, and is ignored if not greater
+/// than zero. The rest is only used by @ref UploadFormat::display_rgba8.
+PixelTransfer
+make_rgb_transfer(const float* rgb, int w, int h, UploadFormat format, const DisplayTransform& display);
+
+/// Describes the transfer of a floating point RGBA image, of which the alpha
+/// channel is ignored. Where the format has a padded variant, it is used
+/// instead, so that the pixels are copied or converted without being
+/// repacked.
+PixelTransfer
+make_rgba_transfer(const float* rgba, int w, int h, UploadFormat format, const DisplayTransform& display);
+
+/// The layouts that 8-bit RGB images can be uploaded in.
+enum class ByteLayout
+{
+  /// Three bytes per pixel, uploaded as is.
+  rgb,
+  /// Padded to four bytes per pixel.
+  rgba,
+  /// Padded to four bytes per pixel, with red and blue swapped. This is the
+  /// native layout of many drivers.
+  bgra
+};
+
+PixelTransfer
+make_rgb_transfer(const unsigned char* rgb, int w, int h, ByteLayout layout = ByteLayout::rgb);
+
+/// Gets the texture format that floating point images are stored in, for the
+/// given upload format.
+GLenum
+get_internal_format(UploadFormat format) noexcept;
+
+/// Gets the texture format that 8-bit images are stored in, for the given layout.
+GLenum
+get_internal_format(ByteLayout layout) noexcept;
+
+} // namespace window_blit
@@ -0,0 +1,123 @@
+#include "readback_ring.hpp"
+
+#include <utility>
+
+namespace window_blit {
+
+namespace {
+
+/// How long to block in a single call to glClientWaitSync, in nanoseconds.
+const GLuint64 g_fence_timeout = 100000000;
+
+} // namespace
+
+ReadbackRing::ReadbackRing(ImageFunction image_function, int buffer_count)
+  : m_image_function(std::move(image_function))
+  , m_slots(buffer_count)
+{
+  for (auto& slot : m_slots)
+    glGenBuffers(1, &slot.buffer);
+}
+
+ReadbackRing::~ReadbackRing()
+{
+  for (auto& slot : m_slots) {
+
+    if (slot.fence)
+      glDeleteSync(slot.fence);
+
+    glDeleteBuffers(1, &slot.buffer);
+  }
+}
+
+void
+ReadbackRing::read(int w, int h)
+{
+  if ((w <= 0) || (h <= 0) || m_slots.empty())
+    return;
+
+  Slot& slot = m_slots[m_next_slot];
+
+  m_next_slot = (m_next_slot + 1) % m_slots.size();
+
+  complete(slot);
+
+  const std::size_t size = std::size_t(w) * std::size_t(h) * 4;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+
+  if (slot.capacity < size) {
+
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+
+    slot.capacity = size;
+  }
+
+  // Rows of four bytes per pixel are never padded, whatever the pack alignment.
+  glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+  if (GLAD_GL_ARB_sync)
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  slot.w = w;
+  slot.h = h;
+  slot.pending = true;
+}
+
+void
+ReadbackRing::finish()
+{
+  // The next slot holds the oldest read.
+  for (std::size_t i = 0; i < m_slots.size(); i++)
+    complete(m_slots[(m_next_slot + i) % m_slots.size()]);
+}
+
+void
+ReadbackRing::complete(Slot& slot)
+{
+  if (!slot.pending)
+    return;
+
+  slot.pending = false;
+
+  wait(slot);
+
+  const std::size_t size = std::size_t(slot.w) * std::size_t(slot.h) * 4;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+
+  const void* pixels = GLAD_GL_VERSION_3_0 ? glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT)
+                                           : glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+
+  if (pixels) {
+
+    m_image_function(static_cast<const unsigned char*>(pixels), slot.w, slot.h);
+
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void
+ReadbackRing::wait(Slot& slot)
+{
+  if (!slot.fence)
+    return;
+
+  for (;;) {
+
+    const GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_fence_timeout);
+
+    if ((result == GL_ALREADY_SIGNALED) || (result == GL_CONDITION_SATISFIED) || (result == GL_WAIT_FAILED))
+      break;
+  }
+
+  glDeleteSync(slot.fence);
+
+  slot.fence = nullptr;
+}
+
+} // namespace window_blit
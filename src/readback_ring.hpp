@@ -0,0 +1,68 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <functional>
+#include <vector>
+
+#include <cstddef>
+
+namespace window_blit {
+
+/// Reads images back from the GPU through a ring of pixel buffer objects.
+///
+/// @details Each read is started with glReadPixels into the next buffer of
+/// the ring, which returns right away while the GPU performs the transfer. A
+/// fence is placed after each transfer and it is only waited on once the ring
+/// wraps back around to that buffer, by which time the transfer has usually
+/// long finished, so that reading back does not stall rendering. The pixels
+/// are then passed to the image function, in the order that they were read.
+class ReadbackRing final
+{
+public:
+  /// Called with each image that finished reading back. The pixels are 8-bit
+  /// RGBA, with the bottom row first, and are only valid during the call.
+  using ImageFunction = std::function<void(const unsigned char* rgba, int w, int h)>;
+
+  ReadbackRing(ImageFunction image_function, int buffer_count = 3);
+
+  ReadbackRing(const ReadbackRing&) = delete;
+
+  ~ReadbackRing();
+
+  /// Starts reading an image out of the framebuffer bound to GL_READ_FRAMEBUFFER.
+  void read(int w, int h);
+
+  /// Waits for all of the reads that are still in progress, oldest first.
+  void finish();
+
+private:
+  struct Slot final
+  {
+    GLuint buffer = 0;
+
+    GLsync fence = nullptr;
+
+    std::size_t capacity = 0;
+
+    int w = 0;
+
+    int h = 0;
+
+    bool pending = false;
+  };
+
+  /// Waits for the read into the slot, if there is one, and passes its pixels to the image function.
+  void complete(Slot& slot);
+
+  static void wait(Slot& slot);
+
+private:
+  ImageFunction m_image_function;
+
+  std::vector<Slot> m_slots;
+
+  std::size_t m_next_slot = 0;
+};
+
+} // namespace window_blit
@@ -0,0 +1,269 @@
+#include "render_thread.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace window_blit {
+
+namespace {
+
+thread_local bool t_is_render_thread = false;
+
+/// The workers and the functions they take turns running.
+class Scheduler final
+{
+public:
+  using Clock = RenderThread::Clock;
+
+  using Function = RenderThread::Function;
+
+  static Scheduler& get()
+  {
+    static Scheduler scheduler;
+
+    return scheduler;
+  }
+
+  ~Scheduler()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      m_stop = true;
+    }
+
+    m_condition.notify_all();
+
+    for (auto& worker : m_workers)
+      worker.join();
+  }
+
+  void set_thread_count(int count)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_thread_count = std::max(count, 1);
+  }
+
+  int add(Function function, float weight)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Started along with the first function, so that processes without any do not have idle threads.
+    while (int(m_workers.size()) < m_thread_count)
+      m_workers.emplace_back(&Scheduler::run_worker, this);
+
+    Job job;
+    job.function = std::move(function);
+    job.weight = std::max(weight, g_min_weight);
+    // A new function starts out even with the others, instead of owing them for all the time they ran.
+    job.charge = m_charge_floor;
+
+    const int id = m_next_id++;
+
+    m_jobs.emplace(id, std::move(job));
+
+    m_condition.notify_one();
+
+    return id;
+  }
+
+  void remove(int id)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto it = m_jobs.find(id);
+
+    if (it == m_jobs.end())
+      return;
+
+    // Otherwise a worker could pick the function again before this thread gets the lock back.
+    it->second.removed = true;
+
+    m_done_condition.wait(lock, [&it] { return !it->second.running; });
+
+    m_jobs.erase(it);
+  }
+
+  void wake(int id)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      auto it = m_jobs.find(id);
+
+      if (it == m_jobs.end())
+        return;
+
+      it->second.woken = true;
+    }
+
+    m_condition.notify_one();
+  }
+
+  void set_weight(int id, float weight)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_jobs.find(id);
+
+    if (it != m_jobs.end())
+      it->second.weight = std::max(weight, g_min_weight);
+  }
+
+private:
+  static constexpr float g_min_weight = 0.001f;
+
+  struct Job final
+  {
+    Function function;
+
+    float weight = 1;
+
+    /// The time the function ran for, in seconds, divided by its weight.
+    double charge = 0;
+
+    Clock::time_point ready_time;
+
+    bool woken = false;
+
+    bool running = false;
+
+    bool removed = false;
+  };
+
+  Scheduler() = default;
+
+  void run_worker()
+  {
+    t_is_render_thread = true;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_stop) {
+
+      const auto now = Clock::now();
+
+      Job* next_job = nullptr;
+
+      auto next_ready_time = Clock::time_point::max();
+
+      for (auto& entry : m_jobs) {
+
+        Job& job = entry.second;
+
+        if (job.running || job.removed)
+          continue;
+
+        if (!job.woken && (job.ready_time > now)) {
+          next_ready_time = std::min(next_ready_time, job.ready_time);
+          continue;
+        }
+
+        if (!next_job || (job.charge < next_job->charge))
+          next_job = &job;
+      }
+
+      if (!next_job) {
+
+        if (next_ready_time == Clock::time_point::max())
+          m_condition.wait(lock);
+        else
+          m_condition.wait_until(lock, next_ready_time);
+
+        continue;
+      }
+
+      // A function that was waiting is not owed the time it spent waiting.
+      next_job->charge = std::max(next_job->charge, m_charge_floor);
+
+      m_charge_floor = next_job->charge;
+
+      next_job->running = true;
+
+      next_job->woken = false;
+
+      lock.unlock();
+
+      const auto start = Clock::now();
+
+      const Clock::duration delay = next_job->function();
+
+      const auto end = Clock::now();
+
+      lock.lock();
+
+      next_job->running = false;
+
+      next_job->charge += std::chrono::duration<double>(end - start).count() / next_job->weight;
+
+      next_job->ready_time = end + delay;
+
+      m_done_condition.notify_all();
+    }
+  }
+
+private:
+  std::mutex m_mutex;
+
+  /// Notified when a function may have become ready to run.
+  std::condition_variable m_condition;
+
+  /// Notified when a function returns.
+  std::condition_variable m_done_condition;
+
+  /// Map nodes keep their address, so workers can hold on to a job while running it unlocked.
+  std::map<int, Job> m_jobs;
+
+  int m_next_id = 0;
+
+  /// The charge of the function that was last run, which is the lowest of the ones ready to run.
+  double m_charge_floor = 0;
+
+  int m_thread_count = 1;
+
+  std::vector<std::thread> m_workers;
+
+  bool m_stop = false;
+};
+
+} // namespace
+
+RenderThread::RenderThread(Function function, float weight)
+  : m_id(Scheduler::get().add(std::move(function), weight))
+{}
+
+RenderThread::~RenderThread()
+{
+  Scheduler::get().remove(m_id);
+}
+
+void
+RenderThread::wake()
+{
+  Scheduler::get().wake(m_id);
+}
+
+void
+RenderThread::set_weight(float weight)
+{
+  Scheduler::get().set_weight(m_id, weight);
+}
+
+bool
+RenderThread::is_render_thread() noexcept
+{
+  return t_is_render_thread;
+}
+
+void
+RenderThread::set_thread_count(int count)
+{
+  Scheduler::get().set_thread_count(count);
+}
+
+} // namespace window_blit
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+
+namespace window_blit {
+
+/// Runs a function over and over on one of the render workers, which are
+/// shared by all of the views in the process, until destroyed.
+///
+/// @details The workers take turns between the functions by fair share: each
+/// function is charged for the time it runs divided by its weight, and the
+/// one that was charged the least runs next. A function is never run by more
+/// than one worker at a time. There is one worker unless @ref
+/// set_thread_count says otherwise, since renderers usually parallelize each
+/// frame on their own.
+class RenderThread final
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Returns how long to wait before calling the function again, unless @ref
+  /// wake is called before that. Functions that have nothing to do return a
+  /// delay instead of blocking, so that the worker can run the others.
+  using Function = std::function<Clock::duration()>;
+
+  RenderThread(Function function, float weight = 1);
+
+  RenderThread(const RenderThread&) = delete;
+
+  /// Waits for the current call of the function to return, if there is one,
+  /// and removes it from the workers.
+  ~RenderThread();
+
+  /// Makes the function run as soon as it is its turn, even if its delay is not over.
+  void wake();
+
+  /// Sets the share of the workers' time that the function gets, relative to the others.
+  void set_weight(float weight);
+
+  /// Indicates whether this is being called from a render worker, which has
+  /// no context and must not make any GL calls.
+  static bool is_render_thread() noexcept;
+
+  /// Sets the number of render workers. Workers are added when the next
+  /// render thread is created, but never removed, so a smaller count than
+  /// there already are workers has no effect.
+  static void set_thread_count(int count);
+
+private:
+  int m_id = 0;
+};
+
+} // namespace window_blit
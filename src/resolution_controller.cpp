@@ -0,0 +1,64 @@
+#include "resolution_controller.hpp"
+
+#include <algorithm>
+
+#include <cmath>
+
+namespace window_blit {
+
+namespace {
+
+/// The lowest scale, below which the image would not be recognizable anymore.
+constexpr float g_min_scale = 0.0625f;
+
+/// How quickly the smoothed frame time follows the measured frame time.
+constexpr double g_smoothing = 0.25;
+
+/// How much of the way to the ideal scale is taken with each change, to avoid overshooting.
+constexpr double g_damping = 0.5;
+
+/// Changes smaller than this fraction of the scale are ignored.
+constexpr double g_hysteresis = 0.05;
+
+} // namespace
+
+void
+ResolutionController::add_measurement(double seconds, double target_seconds) noexcept
+{
+  if ((seconds <= 0) || (target_seconds <= 0))
+    return;
+
+  if (m_frame_time <= 0)
+    m_frame_time = seconds;
+  else
+    m_frame_time += (seconds - m_frame_time) * g_smoothing;
+
+  double ideal_scale = m_scale * std::sqrt(target_seconds / m_frame_time);
+
+  ideal_scale = std::min(std::max(ideal_scale, double(g_min_scale)), 1.0);
+
+  if (std::fabs(ideal_scale - m_scale) <= (m_scale * g_hysteresis))
+    return;
+
+  double scale = m_scale + ((ideal_scale - m_scale) * g_damping);
+
+  // The rest of the way would be ignored by the next measurement, so it is taken right away.
+  if (std::fabs(ideal_scale - scale) <= (scale * g_hysteresis))
+    scale = ideal_scale;
+
+  // The frame time expected at the new scale, so that the old measurements do
+  // not push the scale any further than they already have.
+  m_frame_time *= (scale * scale) / (double(m_scale) * m_scale);
+
+  m_scale = float(scale);
+}
+
+void
+ResolutionController::reset() noexcept
+{
+  m_scale = 1;
+
+  m_frame_time = 0;
+}
+
+} // namespace window_blit
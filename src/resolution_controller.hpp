@@ -0,0 +1,37 @@
+#pragma once
+
+namespace window_blit {
+
+/// Scales the resolution that frames are rendered at, so that the time it
+/// takes to render them stays close to a target.
+///
+/// @details The cost of a frame is assumed to be proportional to its pixel
+/// count, so the scale of each dimension follows the square root of the ratio
+/// between the target and the measured frame time. Measurements are smoothed
+/// and small corrections are ignored, since every change of the resolution
+/// means a resize, which restarts progressive renderers.
+class ResolutionController final
+{
+public:
+  /// Updates the scale with the time it took to render a frame at the current scale.
+  ///
+  /// @param seconds How long the frame took.
+  ///
+  /// @param target_seconds How long frames should take.
+  void add_measurement(double seconds, double target_seconds) noexcept;
+
+  /// Gets the scale to apply to the width and height of the window, which is
+  /// greater than zero and at most one.
+  float get_scale() const noexcept { return m_scale; }
+
+  /// Forgets the measurements and goes back to the full resolution.
+  void reset() noexcept;
+
+private:
+  float m_scale = 1;
+
+  /// The smoothed frame time, or zero if nothing was measured since the scale last changed.
+  double m_frame_time = 0;
+};
+
+} // namespace window_blit
@@ -4,6 +4,98 @@
 
 namespace window_blit {
 
+namespace {
+
+const char* g_vert_shader = R"(
+#version 120
+
+attribute vec2 g_pos;
+
+varying vec2 g_tex_coord;
+
+void
+main()
+{
+  g_tex_coord = vec2((g_pos.x + 1) * 0.5, (1 - g_pos.y) * 0.5);
+
+  gl_Position = vec4(g_pos, 0.0, 1.0);
+}
+)";
+
+const char* g_frag_shader = R"(
+#version 120
+
+uniform sampler2D texture;
+
+varying vec2 g_tex_coord;
+
+uniform float g_sample_weight;
+
+uniform float g_tone_mapping;
+
+uniform float g_srgb;
+
+float hable_tone_map(float x)
+{
+  float A = 0.15;
+  float B = 0.50;
+  float C = 0.10;
+  float D = 0.20;
+  float E = 0.02;
+  float F = 0.30;
+
+  return ((x*(A*x+C*B)+D*E)/(x*(A*x+B)+D*F))-E/F;
+}
+
+vec3 apply_tone_map(vec3 color)
+{
+  float sig = max(color.r, max(color.g, color.b));
+  float luma = dot(color, vec3(0.2126, 0.7152, 0.0722));
+  float coeff = max(sig - 0.18, 1e-6) / max(sig, 1e-6);
+
+  coeff = pow(coeff, 20.0);
+
+  color = mix(color, vec3(luma), coeff);
+
+  sig = mix(sig, luma, coeff);
+
+  return color * vec3(hable_tone_map(sig) / sig);
+}
+
+vec3 to_srgb(vec3 color)
+{
+    bvec3 cutoff = lessThan(color, vec3(0.0031308));
+    vec3 higher = vec3(1.055)*pow(color, vec3(1.0/2.4)) - vec3(0.055);
+    vec3 lower = color * vec3(12.92);
+    return mix(higher, lower, vec3(cutoff.r, cutoff.g, cutoff.b));
+}
+
+void main()
+{
+  vec3 hdr_color = texture2D(texture, g_tex_coord).rgb * g_sample_weight;
+
+  vec3 ldr_color = mix(hdr_color, apply_tone_map(hdr_color), g_tone_mapping);
+
+  vec3 color = mix(ldr_color, to_srgb(ldr_color), g_srgb);
+
+  gl_FragColor = vec4(color, 1.0);
+}
+)";
+
+} // namespace
+
+const char*
+get_display_vert_shader()
+{
+  return g_vert_shader;
+}
+
+const char*
+get_display_frag_shader()
+{
+  return g_frag_shader;
+}
+
 GLuint
 compile_shader(GLenum shader_type,
                const std::string& source,
@@ -7,6 +7,16 @@
 
 namespace window_blit {
 
+/// Gets the source of the vertex shader that draws the image over the window.
+/// It draws a quad from the two component attribute g_pos.
+const char*
+get_display_vert_shader();
+
+/// Gets the source of the fragment shader that applies the display transform
+/// to the image, which @ref encode_display_rgba8 mirrors on the CPU.
+const char*
+get_display_frag_shader();
+
 /// Attempts to compile a shader.
 ///
 /// @return On success, the ID of the shader is returned.
@@ -0,0 +1,60 @@
+#include "slice_controller.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace window_blit {
+
+namespace {
+
+/// How much of the time that is left each slice aims to fill.
+constexpr double g_fill_ratio = 0.5;
+
+/// How quickly the estimated cost follows the measured cost. Lower values are
+/// steadier, higher values adapt faster when the cost of the work changes.
+constexpr double g_smoothing = 0.25;
+
+constexpr double g_min_unit_cost = 1.0e-9;
+
+} // namespace
+
+int
+SliceController::get_slice_size(double time_left, bool first_slice) const noexcept
+{
+  // Until something is measured, one unit is done to find out what it costs.
+  if (m_unit_cost <= 0)
+    return first_slice ? 1 : 0;
+
+  if (time_left < m_unit_cost)
+    return first_slice ? 1 : 0;
+
+  const double units = (time_left * g_fill_ratio) / m_unit_cost;
+
+  const double max_units = std::numeric_limits<int>::max();
+
+  return std::max(1, int(std::min(units, max_units)));
+}
+
+void
+SliceController::add_measurement(int work, double seconds) noexcept
+{
+  if (work <= 0)
+    return;
+
+  // Kept above zero, since a slice can finish within the resolution of the clock.
+  const double unit_cost = std::max(seconds / work, g_min_unit_cost);
+
+  if (m_unit_cost <= 0)
+    m_unit_cost = unit_cost;
+  else
+    m_unit_cost += (unit_cost - m_unit_cost) * g_smoothing;
+}
+
+void
+SliceController::scale_unit_cost(double ratio) noexcept
+{
+  // The next measurement corrects the estimate, but until then it would size the slices for the old amount of work.
+  m_unit_cost *= ratio;
+}
+
+} // namespace window_blit
@@ -0,0 +1,45 @@
+#pragma once
+
+namespace window_blit {
+
+/// Decides how much work to do in each slice of a progressive frame, so that
+/// the slices of a frame fill its time budget without overrunning it.
+///
+/// @details The cost of a unit of work is estimated from a moving average of
+/// the slices measured so far. Each slice is sized to fill half of the time
+/// that is left, so that the estimate is corrected by the next measurement
+/// before the deadline, and the slices shrink as the deadline approaches.
+class SliceController final
+{
+public:
+  /// Gets the number of units of work to do in the next slice.
+  ///
+  /// @param time_left The seconds left until the deadline of the frame.
+  ///
+  /// @param first_slice Whether this is the first slice of the frame, which
+  /// is always at least one unit so that every frame makes progress.
+  ///
+  /// @return The number of units, or zero if not even one fits before the deadline.
+  int get_slice_size(double time_left, bool first_slice) const noexcept;
+
+  /// Updates the estimated cost of a unit of work.
+  ///
+  /// @param work The number of units that were done in the slice.
+  ///
+  /// @param seconds How long the slice took.
+  void add_measurement(int work, double seconds) noexcept;
+
+  /// Adjusts the estimated cost to a change in the amount of work in a unit,
+  /// such as the number of pixels that a sample is taken for.
+  ///
+  /// @param ratio The new amount of work divided by the old one.
+  void scale_unit_cost(double ratio) noexcept;
+
+  /// The estimated seconds per unit of work, or zero if nothing was measured yet.
+  double get_unit_cost() const noexcept { return m_unit_cost; }
+
+private:
+  double m_unit_cost = 0;
+};
+
+} // namespace window_blit
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+
+namespace window_blit {
+
+/// Passes the latest of a series of values from one thread to another,
+/// without either thread waiting on the other.
+///
+/// @details The producer writes to the back value and then swaps it with the
+/// middle one, which is marked as fresh. The consumer swaps the front value
+/// with the middle one whenever it is fresh. Each thread only ever touches the
+/// value it currently holds, so there is no locking, and values that are
+/// published faster than they are consumed are simply skipped.
+template<typename T>
+class TripleBuffer final
+{
+public:
+  /// Gets the value that the producer writes to.
+  T& back() noexcept { return m_values[m_back]; }
+
+  /// Publishes the back value. The producer gets an older value to write to next.
+  void publish() noexcept { m_back = m_middle.exchange(m_back | g_fresh, std::memory_order_acq_rel) & g_index_mask; }
+
+  /// Gets the most recently published value, to be read by the consumer.
+  ///
+  /// @return The value, or null if nothing was published since the last call.
+  T* acquire() noexcept
+  {
+    if (!(m_middle.load(std::memory_order_relaxed) & g_fresh))
+      return nullptr;
+
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & g_index_mask;
+
+    return &m_values[m_front];
+  }
+
+private:
+  static constexpr int g_index_mask = 3;
+
+  static constexpr int g_fresh = 4;
+
+  T m_values[3];
+
+  /// Only accessed by the producer.
+  int m_back = 0;
+
+  /// The index of the value between the threads, along with whether it is fresh.
+  std::atomic<int> m_middle{ 1 };
+
+  /// Only accessed by the consumer.
+  int m_front = 2;
+};
+
+} // namespace window_blit
@@ -0,0 +1,204 @@
+#include "upload_ring.hpp"
+
+#include <cstring>
+
+namespace window_blit {
+
+namespace {
+
+/// How long to block in a single call to glClientWaitSync, in nanoseconds.
+const GLuint64 g_fence_timeout = 100000000;
+
+const GLbitfield g_persistent_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+} // namespace
+
+UploadRing::UploadRing(int buffer_count)
+  : m_slots(buffer_count)
+{
+  for (auto& slot : m_slots)
+    glGenBuffers(1, &slot.buffer);
+}
+
+UploadRing::~UploadRing()
+{
+  // Deleting the buffers also releases any persistent mappings.
+  for (auto& slot : m_slots) {
+
+    if (slot.fence)
+      glDeleteSync(slot.fence);
+
+    glDeleteBuffers(1, &slot.buffer);
+  }
+}
+
+void
+UploadRing::upload(const void* pixels, std::size_t size, int x, int y, int w, int h, GLenum format, GLenum type)
+{
+  upload(size, x, y, w, h, format, type, [pixels, size](void* dst) { std::memcpy(dst, pixels, size); });
+}
+
+void
+UploadRing::upload(std::size_t size, int x, int y, int w, int h, GLenum format, GLenum type, const FillFunction& fill)
+{
+  void* dst = begin_upload(size);
+
+  if (!dst)
+    return;
+
+  fill(dst);
+
+  end_upload(x, y, w, h, format, type);
+}
+
+void*
+UploadRing::begin_upload(std::size_t size)
+{
+  if (!size || m_slots.empty())
+    return nullptr;
+
+  // Skip over the buffer of an upload that is still in progress.
+  if (m_active_slot == &m_slots[m_next_slot])
+    m_next_slot = (m_next_slot + 1) % m_slots.size();
+
+  Slot& slot = m_slots[m_next_slot];
+
+  if (&slot == m_active_slot)
+    return nullptr;
+
+  m_next_slot = (m_next_slot + 1) % m_slots.size();
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+
+  void* dst = map(slot, size);
+
+  // Left unbound so that other pixel transfers in the meantime read from client memory.
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  if (dst)
+    m_active_slot = &slot;
+
+  return dst;
+}
+
+bool
+UploadRing::end_upload(int x, int y, int w, int h, GLenum format, GLenum type)
+{
+  if (!m_active_slot)
+    return false;
+
+  Slot& slot = *m_active_slot;
+
+  m_active_slot = nullptr;
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+
+  // The contents of the buffer can be lost while it is mapped (on a mode
+  // switch, for example). The texture then keeps the previous frame, which is
+  // shown for one more frame instead of stalling to upload the pixels again.
+  if (!slot.mapped && (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return false;
+  }
+
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, format, type, nullptr);
+
+  if (GLAD_GL_ARB_sync)
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  return true;
+}
+
+void
+UploadRing::cancel_upload()
+{
+  if (!m_active_slot)
+    return;
+
+  if (!m_active_slot->mapped) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_active_slot->buffer);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+
+  m_active_slot = nullptr;
+}
+
+void*
+UploadRing::map(Slot& slot, std::size_t size)
+{
+  wait(slot);
+
+  if (use_persistent_mapping()) {
+
+    if (slot.capacity < size) {
+
+      // Immutable storage can't be resized, so the buffer is replaced.
+      glDeleteBuffers(1, &slot.buffer);
+      glGenBuffers(1, &slot.buffer);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+
+      glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, g_persistent_flags);
+
+      slot.mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, g_persistent_flags);
+
+      slot.capacity = slot.mapped ? size : 0;
+    }
+
+    return slot.mapped;
+  }
+
+  if (slot.capacity < size) {
+
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+    slot.capacity = size;
+
+  } else if (!GLAD_GL_ARB_sync) {
+
+    // Without fences, orphan the old storage so that the driver does not have
+    // to wait for the previous transfer out of this buffer.
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, slot.capacity, nullptr, GL_STREAM_DRAW);
+  }
+
+  if (!GLAD_GL_VERSION_3_0)
+    return glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+
+  GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+
+  // The fence already guarantees that the GPU is done with this buffer.
+  if (GLAD_GL_ARB_sync)
+    access |= GL_MAP_UNSYNCHRONIZED_BIT;
+
+  return glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, access);
+}
+
+void
+UploadRing::wait(Slot& slot)
+{
+  if (!slot.fence)
+    return;
+
+  for (;;) {
+
+    const GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_fence_timeout);
+
+    if ((result == GL_ALREADY_SIGNALED) || (result == GL_CONDITION_SATISFIED) || (result == GL_WAIT_FAILED))
+      break;
+  }
+
+  glDeleteSync(slot.fence);
+
+  slot.fence = nullptr;
+}
+
+bool
+UploadRing::use_persistent_mapping() noexcept
+{
+  // Persistent mappings are only safe to write to with fences.
+  return GLAD_GL_ARB_buffer_storage && GLAD_GL_ARB_sync;
+}
+
+} // namespace window_blit
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <functional>
+#include <vector>
+
+#include <cstddef>
+
+namespace window_blit {
+
+/// Streams pixel data to textures through a ring of pixel buffer objects.
+///
+/// @details Each upload is staged in the next buffer of the ring and then
+/// transferred with glTexSubImage2D, which lets the driver perform the copy
+/// asynchronously. A fence is placed after each transfer and it is only waited
+/// on once the ring wraps back around to that buffer, so the CPU can fill the
+/// next frame while the previous one is still being transferred.
+///
+/// When the context supports GL_ARB_buffer_storage, the buffers are mapped
+/// once, persistently, instead of being mapped for every upload.
+class UploadRing final
+{
+public:
+  /// Used to write the pixel data into the mapped staging buffer.
+  using FillFunction = std::function<void(void* dst)>;
+
+  UploadRing(int buffer_count = 3);
+
+  UploadRing(const UploadRing&) = delete;
+
+  ~UploadRing();
+
+  /// Copies the pixels into the texture currently bound to GL_TEXTURE_2D.
+  ///
+  /// @param pixels The pixels to copy. They are tightly packed and have a size
+  /// of @p size bytes.
+  ///
+  /// @note The texture must already have storage for the given rectangle.
+  void upload(const void* pixels,
+              std::size_t size,
+              int x,
+              int y,
+              int w,
+              int h,
+              GLenum format,
+              GLenum type);
+
+  /// Like the other overload, except that the pixels are written directly into
+  /// the staging buffer by @p fill instead of being copied from client memory.
+  void upload(std::size_t size, int x, int y, int w, int h, GLenum format, GLenum type, const FillFunction& fill);
+
+  /// Maps the next buffer of the ring, so that the caller can write pixels into
+  /// it. Other uploads may be done before the matching call to @ref end_upload.
+  ///
+  /// @return A pointer to at least @p size bytes, or null on failure.
+  void* begin_upload(std::size_t size);
+
+  /// Transfers the pixels written since @ref begin_upload into the texture
+  /// currently bound to GL_TEXTURE_2D.
+  ///
+  /// @return False if the contents of the buffer were lost while it was mapped,
+  ///         in which case the texture is left unchanged.
+  bool end_upload(int x, int y, int w, int h, GLenum format, GLenum type);
+
+  /// Unmaps the buffer from @ref begin_upload without transferring it.
+  void cancel_upload();
+
+private:
+  struct Slot final
+  {
+    GLuint buffer = 0;
+
+    GLsync fence = nullptr;
+
+    std::size_t capacity = 0;
+
+    /// The persistent mapping of the buffer, if there is one.
+    void* mapped = nullptr;
+  };
+
+  /// Waits for the last transfer from the slot to finish and maps it for
+  /// writing. The slot must be bound to GL_PIXEL_UNPACK_BUFFER.
+  ///
+  /// @return A pointer to the mapped buffer or null on failure.
+  void* map(Slot& slot, std::size_t size);
+
+  static void wait(Slot& slot);
+
+  static bool use_persistent_mapping() noexcept;
+
+private:
+  std::vector<Slot> m_slots;
+
+  std::size_t m_next_slot = 0;
+
+  /// The slot between @ref begin_upload and @ref end_upload, if any.
+  Slot* m_active_slot = nullptr;
+};
+
+} // namespace window_blit
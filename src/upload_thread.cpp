@@ -0,0 +1,348 @@
+#include "upload_thread.hpp"
+
+#include "pixel_transfer.hpp"
+#include "upload_ring.hpp"
+
+#include <iostream>
+
+#include <cstring>
+
+namespace window_blit {
+
+std::unique_ptr<UploadThread>
+UploadThread::create(GLFWwindow* window)
+{
+  if (!GLAD_GL_ARB_sync) {
+    std::cerr << "Upload thread requires GL_ARB_sync, uploading on the render thread instead." << std::endl;
+    return nullptr;
+  }
+
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  GLFWwindow* shared_window = glfwCreateWindow(1, 1, "", nullptr, window);
+
+  glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+  if (!shared_window) {
+    std::cerr << "Failed to create a shared context, uploading on the render thread instead." << std::endl;
+    return nullptr;
+  }
+
+  return std::unique_ptr<UploadThread>(new UploadThread(shared_window));
+}
+
+UploadThread::UploadThread(GLFWwindow* shared_window)
+  : m_shared_window(shared_window)
+{
+  // Textures are shared between the contexts, so they can be made here.
+  for (auto& slot : m_slots) {
+
+    glGenTextures(1, &slot.texture);
+
+    glBindTexture(GL_TEXTURE_2D, slot.texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  }
+
+  m_thread = std::thread(&UploadThread::run, this);
+}
+
+UploadThread::~UploadThread()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_stop = true;
+  }
+
+  m_condition.notify_one();
+
+  m_thread.join();
+
+  for (auto& slot : m_slots) {
+
+    if (slot.fence)
+      glDeleteSync(slot.fence);
+
+    glDeleteTextures(1, &slot.texture);
+  }
+
+  glfwDestroyWindow(m_shared_window);
+}
+
+void
+UploadThread::submit(const float* rgb, int w, int h, UploadFormat format, const DisplayTransform& display)
+{
+  Job job;
+  job.w = w;
+  job.h = h;
+  job.format = format;
+  job.display = display;
+
+  submit(std::move(job), rgb, std::size_t(w) * std::size_t(h) * sizeof(float) * 3);
+}
+
+void
+UploadThread::submit_rgba(const float* rgba, int w, int h, UploadFormat format, const DisplayTransform& display)
+{
+  Job job;
+  job.rgba = true;
+  job.w = w;
+  job.h = h;
+  job.format = format;
+  job.display = display;
+
+  submit(std::move(job), rgba, std::size_t(w) * std::size_t(h) * sizeof(float) * 4);
+}
+
+void
+UploadThread::submit(const unsigned char* rgb, int w, int h, ByteLayout layout)
+{
+  Job job;
+  job.bytes = true;
+  job.byte_layout = layout;
+  job.w = w;
+  job.h = h;
+
+  submit(std::move(job), rgb, std::size_t(w) * std::size_t(h) * 3);
+}
+
+void
+UploadThread::submit(std::vector<unsigned char>&& rgb,
+                     int w,
+                     int h,
+                     UploadFormat format,
+                     const DisplayTransform& display)
+{
+  Job job;
+  job.w = w;
+  job.h = h;
+  job.format = format;
+  job.display = display;
+  job.data = std::move(rgb);
+
+  submit(std::move(job), std::size_t(w) * std::size_t(h) * sizeof(float) * 3);
+}
+
+void
+UploadThread::submit_rgba(std::vector<unsigned char>&& rgba,
+                          int w,
+                          int h,
+                          UploadFormat format,
+                          const DisplayTransform& display)
+{
+  Job job;
+  job.rgba = true;
+  job.w = w;
+  job.h = h;
+  job.format = format;
+  job.display = display;
+  job.data = std::move(rgba);
+
+  submit(std::move(job), std::size_t(w) * std::size_t(h) * sizeof(float) * 4);
+}
+
+void
+UploadThread::submit(std::vector<unsigned char>&& rgb, int w, int h, ByteLayout layout)
+{
+  Job job;
+  job.bytes = true;
+  job.byte_layout = layout;
+  job.w = w;
+  job.h = h;
+  job.data = std::move(rgb);
+
+  submit(std::move(job), std::size_t(w) * std::size_t(h) * 3);
+}
+
+std::vector<unsigned char>
+UploadThread::take_buffer()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_spare_buffers.empty())
+    return std::vector<unsigned char>();
+
+  std::vector<unsigned char> buffer = std::move(m_spare_buffers.back());
+
+  m_spare_buffers.pop_back();
+
+  return buffer;
+}
+
+void
+UploadThread::submit(Job&& job, const void* pixels, std::size_t size)
+{
+  if ((job.w <= 0) || (job.h <= 0))
+    return;
+
+  job.data = take_buffer();
+
+  // The copy is done without the lock, so that the upload thread is not held up by it.
+  job.data.resize(size);
+
+  std::memcpy(job.data.data(), pixels, size);
+
+  submit(std::move(job), size);
+}
+
+void
+UploadThread::submit(Job&& job, std::size_t size)
+{
+  if ((job.w <= 0) || (job.h <= 0) || (job.data.size() < size))
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_job_pending)
+      m_spare_buffers.emplace_back(std::move(m_pending_job.data));
+
+    m_pending_job = std::move(job);
+
+    m_job_pending = true;
+  }
+
+  m_condition.notify_one();
+}
+
+GLuint
+UploadThread::acquire(float& sample_weight, bool& display_encoded)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_ready_slot >= 0) {
+
+    if (m_presented_slot >= 0) {
+
+      // Covers the draws of the previous texture, which the upload thread
+      // waits on before writing to it again.
+      Slot& previous = m_slots[m_presented_slot];
+
+      if (previous.fence)
+        glDeleteSync(previous.fence);
+
+      previous.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+      // Fences must be flushed before another context waits on them.
+      glFlush();
+    }
+
+    m_presented_slot = m_ready_slot;
+
+    m_ready_slot = -1;
+
+    wait_on_fence(m_slots[m_presented_slot]);
+  }
+
+  if (m_presented_slot < 0)
+    return 0;
+
+  sample_weight = m_slots[m_presented_slot].sample_weight;
+
+  display_encoded = m_slots[m_presented_slot].display_encoded;
+
+  return m_slots[m_presented_slot].texture;
+}
+
+void
+UploadThread::run()
+{
+  glfwMakeContextCurrent(m_shared_window);
+
+  // Pixel store state is per context.
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  {
+    // Scoped so that the buffers are deleted while the context is current.
+    UploadRing upload_ring;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+
+      m_condition.wait(lock, [this] { return m_stop || m_job_pending; });
+
+      if (m_stop)
+        break;
+
+      Job job = std::move(m_pending_job);
+
+      m_job_pending = false;
+
+      // There are three slots, so one is always neither presented nor ready.
+      int slot_index = 0;
+
+      while ((slot_index == m_presented_slot) || (slot_index == m_ready_slot))
+        slot_index++;
+
+      Slot& slot = m_slots[slot_index];
+
+      wait_on_fence(slot);
+
+      lock.unlock();
+
+      const auto* float_data = reinterpret_cast<const float*>(job.data.data());
+
+      const PixelTransfer transfer =
+        job.bytes  ? make_rgb_transfer(job.data.data(), job.w, job.h, job.byte_layout)
+        : job.rgba ? make_rgba_transfer(float_data, job.w, job.h, job.format, job.display)
+                   : make_rgb_transfer(float_data, job.w, job.h, job.format, job.display);
+
+      glBindTexture(GL_TEXTURE_2D, slot.texture);
+
+      if ((slot.w != job.w) || (slot.h != job.h) || (slot.internal_format != transfer.internal_format)) {
+
+        glTexImage2D(GL_TEXTURE_2D, 0, transfer.internal_format, job.w, job.h, 0, GL_RGB, GL_FLOAT, nullptr);
+
+        slot.w = job.w;
+        slot.h = job.h;
+        slot.internal_format = transfer.internal_format;
+      }
+
+      upload_ring.upload(transfer.size, 0, 0, job.w, job.h, transfer.format, transfer.type, transfer.fill);
+
+      GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+      glFlush();
+
+      lock.lock();
+
+      slot.fence = fence;
+
+      slot.sample_weight = transfer.sample_weight;
+
+      slot.display_encoded = transfer.display_encoded;
+
+      // A ready texture that was never presented is simply dropped.
+      m_ready_slot = slot_index;
+
+      m_spare_buffers.emplace_back(std::move(job.data));
+
+      // Wakes the window thread, in case it is waiting for events, so that the texture gets presented.
+      glfwPostEmptyEvent();
+    }
+  }
+
+  glfwMakeContextCurrent(nullptr);
+}
+
+void
+UploadThread::wait_on_fence(Slot& slot)
+{
+  if (!slot.fence)
+    return;
+
+  // This only makes the GPU wait, the calling thread continues right away.
+  glWaitSync(slot.fence, 0, GL_TIMEOUT_IGNORED);
+
+  glDeleteSync(slot.fence);
+
+  slot.fence = nullptr;
+}
+
+} // namespace window_blit
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <window_blit/app_base.hpp>
+
+#include "pixel_transfer.hpp"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace window_blit {
+
+/// Uploads images on a background thread, which has its own context that
+/// shares objects with the context of the window.
+///
+/// @details Images are copied or moved into a staging buffer and queued, so
+/// that the render thread returns right away. The uploads go into a set of three
+/// textures: one being presented, one waiting to be presented and one being
+/// written to. Presentation makes the GPU wait on a fence placed after the
+/// upload, and the upload thread does the same with a fence placed after the
+/// last draw of a texture before writing to it again.
+class UploadThread final
+{
+public:
+  /// Creates the upload thread. Must be called from the main thread, while the
+  /// context of @p window is current.
+  ///
+  /// @return The upload thread, or null if the context does not support
+  /// fences or a shared context could not be created.
+  static std::unique_ptr<UploadThread> create(GLFWwindow* window);
+
+  UploadThread(const UploadThread&) = delete;
+
+  ~UploadThread();
+
+  /// Queues an image for upload. If an earlier image has not been uploaded
+  /// yet, it is replaced by this one.
+  ///
+  /// @details The image is copied into a staging buffer on the calling
+  /// thread, so the caller may reuse it as soon as this returns. The overloads
+  /// that take a vector avoid the copy.
+  void submit(const float* rgb, int w, int h, UploadFormat format, const DisplayTransform& display);
+
+  void submit_rgba(const float* rgba, int w, int h, UploadFormat format, const DisplayTransform& display);
+
+  void submit(const unsigned char* rgb, int w, int h, ByteLayout layout);
+
+  /// Queues an image for upload, taking ownership of the buffer it is in
+  /// instead of copying it. The buffer must hold at least the whole image.
+  void submit(std::vector<unsigned char>&& rgb, int w, int h, UploadFormat format, const DisplayTransform& display);
+
+  void submit_rgba(std::vector<unsigned char>&& rgba, int w, int h, UploadFormat format, const DisplayTransform& display);
+
+  void submit(std::vector<unsigned char>&& rgb, int w, int h, ByteLayout layout);
+
+  /// Takes a staging buffer that is no longer in use by the upload thread, so
+  /// that the buffers handed over by @ref submit get reused.
+  ///
+  /// @return The buffer, which is empty if there is no spare one.
+  std::vector<unsigned char> take_buffer();
+
+  /// Gets the most recently uploaded texture, to be drawn by the current
+  /// context. The current context is made to wait for the upload to complete.
+  ///
+  /// @param sample_weight Assigned the sample weight already applied to the texels.
+  ///
+  /// @param display_encoded Assigned whether the whole display transform was
+  /// already applied to the texels.
+  ///
+  /// @return The texture, or zero if nothing has been uploaded yet.
+  GLuint acquire(float& sample_weight, bool& display_encoded);
+
+private:
+  struct Job final
+  {
+    bool bytes = false;
+
+    /// Whether the floating point pixels have four channels.
+    bool rgba = false;
+
+    int w = 0;
+
+    int h = 0;
+
+    UploadFormat format = UploadFormat::rgb32f;
+
+    ByteLayout byte_layout = ByteLayout::rgb;
+
+    DisplayTransform display;
+
+    std::vector<unsigned char> data;
+  };
+
+  struct Slot final
+  {
+    GLuint texture = 0;
+
+    int w = 0;
+
+    int h = 0;
+
+    GLenum internal_format = GL_NONE;
+
+    float sample_weight = 1;
+
+    bool display_encoded = false;
+
+    /// Guards the next use of the texture, by either thread.
+    GLsync fence = nullptr;
+  };
+
+  UploadThread(GLFWwindow* shared_window);
+
+  void submit(Job&& job, const void* pixels, std::size_t size);
+
+  void submit(Job&& job, std::size_t size);
+
+  void run();
+
+  static void wait_on_fence(Slot& slot);
+
+private:
+  /// A hidden window, used for its context.
+  GLFWwindow* m_shared_window = nullptr;
+
+  std::mutex m_mutex;
+
+  std::condition_variable m_condition;
+
+  bool m_stop = false;
+
+  bool m_job_pending = false;
+
+  Job m_pending_job;
+
+  /// Staging buffers that are not in use, kept to avoid reallocating them.
+  std::vector<std::vector<unsigned char>> m_spare_buffers;
+
+  Slot m_slots[3];
+
+  int m_presented_slot = -1;
+
+  int m_ready_slot = -1;
+
+  std::thread m_thread;
+};
+
+} // namespace window_blit
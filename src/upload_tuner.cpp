@@ -0,0 +1,374 @@
+#include "upload_tuner.hpp"
+
+#include "upload_ring.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <cstdlib>
+
+namespace window_blit {
+
+namespace {
+
+/// The width and height of the test image.
+const int g_image_size = 512;
+
+/// The uploads done before the timing starts, to get buffer and texture
+/// allocations out of the way.
+const int g_warmup_count = 2;
+
+const int g_upload_count = 8;
+
+/// How much faster a candidate has to be than the best one before it to be
+/// chosen, so that timing noise does not cost precision or memory for nothing.
+const double g_precision_margin = 0.9;
+
+/// Changed whenever the candidates change, so that old cache entries are ignored.
+const char g_cache_version[] = "1";
+
+struct FloatCandidate final
+{
+  UploadFormat format;
+
+  const char* name;
+};
+
+/// Ordered from the most to the least precise.
+const FloatCandidate g_float_candidates[]{ { UploadFormat::rgb32f, "rgb32f" },
+                                           { UploadFormat::rgba32f, "rgba32f" },
+                                           { UploadFormat::rgb16f, "rgb16f" },
+                                           { UploadFormat::rgba16f, "rgba16f" },
+                                           { UploadFormat::rgb9_e5, "rgb9_e5" } };
+
+struct ByteCandidate final
+{
+  ByteLayout layout;
+
+  const char* name;
+};
+
+const ByteCandidate g_byte_candidates[]{ { ByteLayout::rgb, "rgb" },
+                                         { ByteLayout::rgba, "rgba" },
+                                         { ByteLayout::bgra, "bgra" } };
+
+std::string
+get_gl_string(GLenum name)
+{
+  const auto* str = reinterpret_cast<const char*>(glGetString(name));
+
+  return str ? str : "";
+}
+
+std::string
+get_cache_key()
+{
+  return std::string(g_cache_version) + '|' + get_gl_string(GL_VENDOR) + '|' + get_gl_string(GL_RENDERER) + '|' +
+         get_gl_string(GL_VERSION);
+}
+
+std::filesystem::path
+get_cache_path()
+{
+  std::filesystem::path dir;
+
+#ifdef _WIN32
+  if (const char* local_app_data = std::getenv("LOCALAPPDATA"))
+    dir = local_app_data;
+#else
+  if (const char* cache_home = std::getenv("XDG_CACHE_HOME"))
+    dir = cache_home;
+  else if (const char* home = std::getenv("HOME"))
+    dir = std::filesystem::path(home) / ".cache";
+#endif
+
+  if (dir.empty())
+    return std::filesystem::path();
+
+  return dir / "window_blit" / "upload_formats.txt";
+}
+
+/// Reads the lines of the cache file, which are each a key followed by the
+/// names of the chosen formats, separated by tabs.
+std::vector<std::string>
+read_cache_lines(const std::filesystem::path& path)
+{
+  std::vector<std::string> lines;
+
+  std::ifstream file(path);
+
+  std::string line;
+
+  while (std::getline(file, line)) {
+    if (!line.empty())
+      lines.emplace_back(line);
+  }
+
+  return lines;
+}
+
+bool
+parse_cache_line(const std::string& line, const std::string& key, UploadPreferences& preferences)
+{
+  if (line.compare(0, key.size() + 1, key + '\t') != 0)
+    return false;
+
+  const auto first_tab = key.size();
+
+  const auto second_tab = line.find('\t', first_tab + 1);
+
+  if (second_tab == std::string::npos)
+    return false;
+
+  const std::string float_name = line.substr(first_tab + 1, second_tab - (first_tab + 1));
+
+  const std::string byte_name = line.substr(second_tab + 1);
+
+  bool float_found = false;
+
+  for (const auto& candidate : g_float_candidates) {
+    if (float_name == candidate.name) {
+      preferences.float_format = candidate.format;
+      float_found = true;
+    }
+  }
+
+  bool byte_found = false;
+
+  for (const auto& candidate : g_byte_candidates) {
+    if (byte_name == candidate.name) {
+      preferences.byte_layout = candidate.layout;
+      byte_found = true;
+    }
+  }
+
+  return float_found && byte_found;
+}
+
+/// Measures how long it takes to upload the test image a number of times.
+///
+/// @return The time in seconds, or infinity if the format is not supported.
+double
+time_uploads(UploadRing& upload_ring, const std::function<PixelTransfer()>& make_transfer)
+{
+  while (glGetError() != GL_NO_ERROR) {
+  }
+
+  GLuint texture = 0;
+
+  glGenTextures(1, &texture);
+
+  glBindTexture(GL_TEXTURE_2D, texture);
+
+  glTexImage2D(
+    GL_TEXTURE_2D, 0, make_transfer().internal_format, g_image_size, g_image_size, 0, GL_RGB, GL_FLOAT, nullptr);
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < (g_warmup_count + g_upload_count); i++) {
+
+    if (i == g_warmup_count) {
+      glFinish();
+      start = std::chrono::steady_clock::now();
+    }
+
+    const PixelTransfer transfer = make_transfer();
+
+    upload_ring.upload(
+      transfer.size, 0, 0, g_image_size, g_image_size, transfer.format, transfer.type, transfer.fill);
+  }
+
+  glFinish();
+
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  const bool failed = glGetError() != GL_NO_ERROR;
+
+  glDeleteTextures(1, &texture);
+
+  return failed ? std::numeric_limits<double>::infinity() : elapsed.count();
+}
+
+UploadPreferences
+measure_preferences(UploadRing& upload_ring)
+{
+  const std::size_t pixel_count = std::size_t(g_image_size) * std::size_t(g_image_size);
+
+  // Varied and above one, so that none of the conversions can take a shortcut.
+  std::vector<float> float_image(pixel_count * 3);
+
+  std::vector<unsigned char> byte_image(pixel_count * 3);
+
+  for (std::size_t i = 0; i < float_image.size(); i++) {
+    float_image[i] = float((i * 7) % 256) / 32.0f;
+    byte_image[i] = static_cast<unsigned char>((i * 7) % 256);
+  }
+
+  UploadPreferences preferences;
+
+  double best_time = std::numeric_limits<double>::infinity();
+
+  for (const auto& candidate : g_float_candidates) {
+
+    const double time = time_uploads(upload_ring, [&float_image, &candidate] {
+      return make_rgb_transfer(float_image.data(), g_image_size, g_image_size, candidate.format, DisplayTransform());
+    });
+
+    if (time < (best_time * g_precision_margin)) {
+      preferences.float_format = candidate.format;
+      best_time = time;
+    }
+  }
+
+  best_time = std::numeric_limits<double>::infinity();
+
+  for (const auto& candidate : g_byte_candidates) {
+
+    const double time = time_uploads(upload_ring, [&byte_image, &candidate] {
+      return make_rgb_transfer(byte_image.data(), g_image_size, g_image_size, candidate.layout);
+    });
+
+    if (time < best_time) {
+      preferences.byte_layout = candidate.layout;
+      best_time = time;
+    }
+  }
+
+  return preferences;
+}
+
+} // namespace
+
+bool
+read_cached_preferences(const std::filesystem::path& path, const std::string& key, UploadPreferences& preferences)
+{
+  for (const auto& line : read_cache_lines(path)) {
+
+    // A line that is only partly valid leaves the preferences unchanged.
+    UploadPreferences parsed;
+
+    if (parse_cache_line(line, key, parsed)) {
+      preferences = parsed;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void
+store_cached_preferences(const std::filesystem::path& path,
+                         const std::string& key,
+                         const UploadPreferences& preferences)
+{
+  std::vector<std::string> lines = read_cache_lines(path);
+
+  std::string line = key + '\t';
+
+  for (const auto& candidate : g_float_candidates) {
+    if (candidate.format == preferences.float_format)
+      line += candidate.name;
+  }
+
+  line += '\t';
+
+  for (const auto& candidate : g_byte_candidates) {
+    if (candidate.layout == preferences.byte_layout)
+      line += candidate.name;
+  }
+
+  bool replaced = false;
+
+  for (auto& existing : lines) {
+    if (existing.compare(0, key.size() + 1, key + '\t') == 0) {
+      existing = line;
+      replaced = true;
+    }
+  }
+
+  if (!replaced)
+    lines.emplace_back(line);
+
+  std::error_code error;
+
+  std::filesystem::create_directories(path.parent_path(), error);
+
+  // Written to a file of its own and then renamed over the cache, so that a
+  // process starting at the same time never reads a partly written cache.
+  std::filesystem::path temp_path = path;
+
+  temp_path += '.' + std::to_string(std::random_device()()) + ".tmp";
+
+  {
+    std::ofstream file(temp_path);
+
+    for (const auto& l : lines)
+      file << l << '\n';
+
+    file.close();
+
+    if (file.fail()) {
+      std::filesystem::remove(temp_path, error);
+      return;
+    }
+  }
+
+  std::filesystem::rename(temp_path, path, error);
+
+  if (error)
+    std::filesystem::remove(temp_path, error);
+}
+
+UploadPreferences
+get_upload_preferences()
+{
+  const std::string key = get_cache_key();
+
+  // The results of this process, so that each window does not read the cache
+  // file again, and windows opened together do not all run the measurements.
+  static std::mutex mutex;
+
+  static std::map<std::string, UploadPreferences> known_preferences;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto known = known_preferences.find(key);
+
+  if (known != known_preferences.end())
+    return known->second;
+
+  const std::filesystem::path cache_path = get_cache_path();
+
+  UploadPreferences preferences;
+
+  if (!cache_path.empty() && read_cached_preferences(cache_path, key, preferences)) {
+    known_preferences.emplace(key, preferences);
+    return preferences;
+  }
+
+  {
+    // A ring of its own, so that the buffers of the application are not
+    // allocated for the size of the test image.
+    UploadRing upload_ring;
+
+    preferences = measure_preferences(upload_ring);
+  }
+
+  if (!cache_path.empty())
+    store_cached_preferences(cache_path, key, preferences);
+
+  known_preferences.emplace(key, preferences);
+
+  return preferences;
+}
+
+} // namespace window_blit
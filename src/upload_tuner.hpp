@@ -0,0 +1,52 @@
+#pragma once
+
+#include <window_blit/app_base.hpp>
+
+#include "pixel_transfer.hpp"
+
+#include <filesystem>
+#include <string>
+
+namespace window_blit {
+
+/// The upload formats that were measured to be the fastest.
+struct UploadPreferences final
+{
+  /// Used for floating point images. This is never @ref UploadFormat::automatic.
+  UploadFormat float_format = UploadFormat::rgb32f;
+
+  ByteLayout byte_layout = ByteLayout::rgb;
+};
+
+/// Finds the fastest way of uploading each type of image with the current
+/// context.
+///
+/// @details Each candidate format is timed over a few uploads of a test image,
+/// including the time to convert the pixels. Since the result only depends on
+/// the driver and the hardware, it is stored in a cache file keyed by the
+/// vendor, renderer and version strings of the context, so the measurements
+/// only run the first time an application is started with a given driver. The
+/// cache is in the user cache directory (XDG_CACHE_HOME, ~/.cache or
+/// LOCALAPPDATA), which is replaced as a whole whenever it changes. The
+/// result is also kept for the rest of the process, for the other windows.
+///
+/// The uploads go through an @ref UploadRing, like the images of the
+/// application. This must be called on a thread with a current context.
+UploadPreferences
+get_upload_preferences();
+
+/// Reads the preferences stored for @p key in a cache file. Lines that are
+/// not complete entries, such as those of a partly written file, are ignored.
+///
+/// @return False if the file has no valid entry for @p key.
+bool
+read_cached_preferences(const std::filesystem::path& path, const std::string& key, UploadPreferences& preferences);
+
+/// Stores the preferences for @p key in a cache file, keeping the entries for
+/// other keys. Failures are ignored, since the cache only saves time.
+void
+store_cached_preferences(const std::filesystem::path& path,
+                         const std::string& key,
+                         const UploadPreferences& preferences);
+
+} // namespace window_blit
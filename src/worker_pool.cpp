@@ -0,0 +1,189 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace window_blit {
+
+namespace {
+
+/// A call to @ref WorkerPool::run, which the workers take chunks of.
+struct Job final
+{
+  const WorkerPool::Function* function = nullptr;
+
+  std::size_t chunk_count = 0;
+
+  std::atomic<std::size_t> next_chunk{ 0 };
+
+  /// The chunks that returned. Guarded by the mutex of the pool, like the rest below.
+  std::size_t finished_count = 0;
+
+  /// The workers that took the job and may still access it.
+  int worker_count = 0;
+};
+
+class Pool final
+{
+public:
+  static Pool& get()
+  {
+    static Pool pool;
+
+    return pool;
+  }
+
+  ~Pool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      m_stop = true;
+    }
+
+    m_condition.notify_all();
+
+    for (auto& worker : m_workers)
+      worker.join();
+  }
+
+  int get_thread_count() const { return int(m_workers.size()) + 1; }
+
+  void run(std::size_t chunk_count, const WorkerPool::Function& function)
+  {
+    if (chunk_count == 0)
+      return;
+
+    if ((chunk_count == 1) || m_workers.empty()) {
+      for (std::size_t i = 0; i < chunk_count; i++)
+        function(i);
+      return;
+    }
+
+    Job job;
+    job.function = &function;
+    job.chunk_count = chunk_count;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      m_jobs.push_back(&job);
+    }
+
+    m_condition.notify_all();
+
+    const std::size_t finished_here = work_on(job);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // No worker can take the job once it is out of the queue, so only the ones that already did are waited for.
+    auto it = std::find(m_jobs.begin(), m_jobs.end(), &job);
+
+    if (it != m_jobs.end())
+      m_jobs.erase(it);
+
+    job.finished_count += finished_here;
+
+    m_done_condition.wait(lock, [&job] { return (job.finished_count == job.chunk_count) && !job.worker_count; });
+  }
+
+private:
+  Pool()
+  {
+    const unsigned int thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (unsigned int i = 1; i < thread_count; i++)
+      m_workers.emplace_back(&Pool::run_worker, this);
+  }
+
+  /// Calls the function of the job for chunks until there are none left.
+  ///
+  /// @return The number of chunks that were called.
+  static std::size_t work_on(Job& job)
+  {
+    std::size_t count = 0;
+
+    for (;;) {
+
+      const std::size_t chunk = job.next_chunk.fetch_add(1, std::memory_order_relaxed);
+
+      if (chunk >= job.chunk_count)
+        return count;
+
+      (*job.function)(chunk);
+
+      count++;
+    }
+  }
+
+  void run_worker()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+
+      m_condition.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+
+      if (m_stop)
+        return;
+
+      Job& job = *m_jobs.front();
+
+      job.worker_count++;
+
+      lock.unlock();
+
+      const std::size_t count = work_on(job);
+
+      lock.lock();
+
+      // Every chunk was taken once a worker runs out, so there is nothing left to hand out.
+      auto it = std::find(m_jobs.begin(), m_jobs.end(), &job);
+
+      if (it != m_jobs.end())
+        m_jobs.erase(it);
+
+      job.finished_count += count;
+
+      job.worker_count--;
+
+      m_done_condition.notify_all();
+    }
+  }
+
+private:
+  std::mutex m_mutex;
+
+  /// Notified when a job is queued.
+  std::condition_variable m_condition;
+
+  /// Notified when a worker is done with a job.
+  std::condition_variable m_done_condition;
+
+  std::deque<Job*> m_jobs;
+
+  std::vector<std::thread> m_workers;
+
+  bool m_stop = false;
+};
+
+} // namespace
+
+void
+WorkerPool::run(std::size_t chunk_count, const Function& function)
+{
+  Pool::get().run(chunk_count, function);
+}
+
+int
+WorkerPool::get_thread_count()
+{
+  return Pool::get().get_thread_count();
+}
+
+} // namespace window_blit
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace window_blit {
+
+/// Runs the chunks of a function in parallel, on a pool of workers shared by
+/// the whole process.
+///
+/// @details The workers are started the first time they are needed, one for
+/// each hardware thread but the calling one. The calling thread works on the
+/// chunks too, so calls from several threads at once, or from a worker, make
+/// progress even while all of the workers are busy.
+class WorkerPool final
+{
+public:
+  /// Called with the index of each chunk.
+  using Function = std::function<void(std::size_t chunk)>;
+
+  /// Calls the function once for each chunk, in no particular order, and
+  /// returns once all of the calls have returned.
+  static void run(std::size_t chunk_count, const Function& function);
+
+  /// Gets the number of threads that work on the chunks, including the calling one.
+  static int get_thread_count();
+};
+
+} // namespace window_blit